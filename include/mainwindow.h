@@ -4,13 +4,28 @@
 #include <QFileDialog>
 #include <QFontDatabase>
 #include <QMainWindow>
+#include <QThreadPool>
+#include <QTimer>
 #include <QtWidgets>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
 #include "maze.h"
 #include "maze_builder.h"
 #include "maze_serializer.h"
 #include "maze_view.h"
 
+/// Путь решения лабиринта: ячейки от старта до финиша
+using MazePath = std::vector<std::pair<int, int>>;
+
+Q_DECLARE_METATYPE(std::shared_ptr<Maze>)
+Q_DECLARE_METATYPE(MazeDescriptor)
+Q_DECLARE_METATYPE(MazePath)
+
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class MainWindow;
@@ -21,6 +36,17 @@ QT_END_NAMESPACE
  * @class MainWindow
  * @brief Основное окно приложения. Содержит элементы управления и область
  * отрисовки лабиринта
+ *
+ * Генерация, загрузка и решение лабиринта выполняются фоновыми задачами в
+ * отдельном потоке, результаты возвращаются сигналами, поэтому окно не
+ * замирает на больших лабиринтах. Одновременно выполняется одна задача; ее
+ * можно отменить кнопкой, а по истечении TASK_TIME_BUDGET_MS она отменяется
+ * сама. Генерация и загрузка сжатых файлов и описаний проверяют отмену
+ * после каждой строки и прерываются сразу, остальные загрузки и решение не
+ * прерываются, а их результат отбрасывается. Ошибка задачи, например
+ * нехватка памяти, показывается на индикаторе. Кнопки задач остаются
+ * недоступны, пока фоновый поток не освободится, поэтому новая задача не
+ * ждет молча за отмененной.
  */
 class MainWindow : public QMainWindow {
   Q_OBJECT
@@ -29,6 +55,8 @@ class MainWindow : public QMainWindow {
   constexpr static int DEFAULT_ROWS = 10;
   /// Количество столбцов по умолчанию для генерации лабиринта
   constexpr static int DEFAULT_COLS = 10;
+  /// Ограничение времени фоновой задачи в миллисекундах
+  constexpr static int TASK_TIME_BUDGET_MS = 60000;
 
  public:
   /**
@@ -81,12 +109,184 @@ class MainWindow : public QMainWindow {
    */
   void showMazeSolution();
 
+  /**
+   * @brief Слот для отмены текущей фоновой задачи
+   */
+  void cancelTask();
+
+ signals:
+  /**
+   * @brief Сигнал о ходе фоновой задачи
+   * @param[in] task номер задачи
+   * @param[in] percent выполненная часть задачи в процентах
+   */
+  void taskProgress(int task, int percent);
+
+  /**
+   * @brief Сигнал о готовности сгенерированного лабиринта
+   * @param[in] task номер задачи
+   * @param[in] maze лабиринт
+   * @param[in] descriptor описание лабиринта
+   */
+  void mazeGenerated(int task, std::shared_ptr<Maze> maze,
+                     MazeDescriptor descriptor);
+
+  /**
+   * @brief Сигнал о готовности загруженного лабиринта
+   * @param[in] task номер задачи
+   * @param[in] maze лабиринт
+   * @param[in] file_name имя файла лабиринта
+   */
+  void mazeLoaded(int task, std::shared_ptr<Maze> maze, QString file_name);
+
+  /**
+   * @brief Сигнал о готовности решения лабиринта
+   * @param[in] task номер задачи
+   * @param[in] path путь решения лабиринта
+   */
+  void solutionFound(int task, MazePath path);
+
+  /**
+   * @brief Сигнал о том, что фоновый поток завершил задачу, в том числе
+   * отмененную, и свободен для следующей
+   */
+  void taskFinished();
+
+  /**
+   * @brief Сигнал об ошибке фоновой задачи (например, нехватке памяти)
+   * @param[in] task номер задачи
+   * @param[in] message сообщение на индикаторе
+   */
+  void taskFailed(int task, QString message);
+
+ private slots:
+  /**
+   * @brief Обновляет индикатор хода текущей задачи
+   * @param[in] task номер задачи
+   * @param[in] percent выполненная часть задачи в процентах
+   */
+  void updateTaskProgress(int task, int percent);
+
+  /**
+   * @brief Отображает сгенерированный лабиринт
+   * @param[in] task номер задачи
+   * @param[in] maze лабиринт
+   * @param[in] descriptor описание лабиринта
+   */
+  void setGeneratedMaze(int task, std::shared_ptr<Maze> maze,
+                        MazeDescriptor descriptor);
+
+  /**
+   * @brief Отображает загруженный лабиринт
+   * @param[in] task номер задачи
+   * @param[in] maze лабиринт
+   * @param[in] file_name имя файла лабиринта
+   */
+  void setLoadedMaze(int task, std::shared_ptr<Maze> maze, QString file_name);
+
+  /**
+   * @brief Отображает решение лабиринта
+   * @param[in] task номер задачи
+   * @param[in] path путь решения лабиринта
+   */
+  void setMazeSolution(int task, MazePath path);
+
+  /**
+   * @brief Отменяет текущую задачу по истечении отведенного ей времени
+   */
+  void stopOverdueTask();
+
+  /**
+   * @brief Завершает текущую задачу, когда фоновый поток освободился
+   */
+  void releaseWorker();
+
+  /**
+   * @brief Запоминает сообщение об ошибке текущей задачи
+   * @param[in] task номер задачи
+   * @param[in] message сообщение на индикаторе
+   */
+  void reportTaskFailure(int task, QString message);
+
  private:
+  /**
+   * @brief Запускает работу задачи в фоновом потоке. По ее окончании
+   * испускается taskFinished, а исключение работы превращается в taskFailed.
+   * @param[in] task номер задачи
+   * @param[in] failure сообщение на индикаторе при исключении
+   * @param[in] work работа задачи
+   */
+  void runTask(int task, const QString &failure, std::function<void()> work);
+
+  /**
+   * @brief Создает приемник строк фоновой задачи: копирует строки в
+   * хранилище, сообщает о ходе и прерывает передачу при отмене. Вызывается
+   * из фонового потока.
+   * @param[in] task номер задачи
+   * @param[out] grid хранилище строк
+   * @return Приемник строк
+   */
+  MazeRowSink collectRows(int task, MazeGrid &grid);
+
+  /**
+   * @brief Загружает лабиринт. Сжатый файл и описание читаются по строкам,
+   * поэтому их загрузка показывает ход и прерывается при отмене; остальные
+   * форматы читаются MazeSerializer::readFromFile целиком. Вызывается из
+   * фонового потока.
+   * @param[in] task номер задачи
+   * @param[in] path путь к файлу
+   * @return Лабиринт, пустой при ошибке или отмене
+   */
+  std::shared_ptr<Maze> readMaze(int task, const std::string &path);
+
+  /**
+   * @brief Отменяет текущую задачу. Кнопки задач и индикатор освобождаются,
+   * когда фоновый поток закончит отмененную задачу.
+   * @param[in] message сообщение на индикаторе после остановки
+   */
+  void stopTask(const QString &message);
+
+  /**
+   * @brief Начинает новую фоновую задачу: блокирует кнопки, показывает
+   * индикатор хода и запускает отсчет времени задачи
+   * @param[in] title название задачи на индикаторе
+   * @param[in] determinate true - задача сообщает о ходе в процентах, иначе
+   * индикатор показывает только занятость
+   * @return Номер задачи
+   */
+  int startTask(const QString &title, bool determinate);
+
+  /**
+   * @brief Завершает текущую задачу: восстанавливает кнопки и индикатор
+   * @param[in] message сообщение на индикаторе
+   */
+  void finishTask(const QString &message);
+
+  /**
+   * @brief Проверяет, что задача отменена или заменена новой. Вызывается из
+   * фонового потока.
+   * @param[in] task номер задачи
+   * @return true, если результат задачи больше не нужен
+   */
+  bool isCancelled(int task) const { return task != task_id_.load(); }
+
   /// UI-форма
   Ui::MainWindow *ui;
-  /// Экземпляр лабиринта
-  Maze maze_;
+  /// Экземпляр лабиринта; фоновое решение держит свою ссылку на него
+  std::shared_ptr<Maze> maze_;
   /// Экземпляр строителя лабиринта
   MazeBuilder bldr_;
+  /// Описание текущего лабиринта, если он сгенерирован, а не загружен
+  std::optional<MazeDescriptor> descriptor_;
+  /// Поток фоновых задач. Задачи выполняются по очереди, поэтому строитель
+  /// используется только в нем, а отброшенная задача завершается раньше
+  /// следующей.
+  QThreadPool pool_;
+  /// Номер текущей задачи; задачи с другим номером отменены
+  std::atomic<int> task_id_;
+  /// Таймер ограничения времени фоновой задачи
+  QTimer task_timer_;
+  /// Сообщение на индикаторе после завершения текущей задачи
+  QString task_message_;
 };
 #endif  // MAINWINDOW_H
@@ -3,39 +3,76 @@
 
 #include <algorithm>
 #include <iostream>
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <utility>
 #include <vector>
 
+#include "maze_grid.h"
+#include "maze_tree_index.h"
+#include "solver_workspace.h"
+
 /**
  * @class Maze
- * @brief Класс лабиринта. Хранит матрицу стен лабиринта, матрицу вершин
- * лабиринта и список смежности графа
+ * @brief Класс лабиринта. Хранит битовые плоскости стен лабиринта, которые
+ * одновременно служат неявным графом для поиска пути
+ *
+ * Все константные методы реентерабельны: один загруженный лабиринт можно
+ * опрашивать из нескольких потоков через const Maze& без копирования.
+ *
+ * Ячейки нумеруются числами int, поэтому лабиринт содержит не больше
+ * MazeGrid::MAX_CELLS ячеек. Битовое хранилище позволяет разместить и
+ * большие лабиринты, но генераторы и загрузчики такие размеры отвергают, а
+ * конструктор их не проверяет.
  */
 class Maze {
  public:
   friend class MazeBuilder;
   friend class MazeSerializer;
 
+  /// Тип стены в ячейке лабиринта
+  using Wall = MazeGrid::Wall;
+
+  /**
+   * @enum SolveMethod
+   * @brief Определяет алгоритм поиска пути в лабиринте.
+   */
+  enum SolveMethod {
+    BFS = 0,                ///< Обход в ширину от точки старта
+    BIDIRECTIONAL_BFS = 1,  ///< Встречный обход в ширину от старта и финиша
+    A_STAR = 2,             ///< A* с очередью на двоичной куче
+    A_STAR_BUCKET = 3,      ///< A* с очередью на корзинах
+    TREE_INDEX = 4          ///< Запрос к индексу идеального лабиринта
+  };
+
   /**
-   * @enum Wall
-   * @brief Определяет тип стены в ячейке лабиринта.
+   * @struct DistanceField
+   * @brief Поле расстояний: длина кратчайшего пути от ближайшего источника до
+   * каждой ячейки и родитель ячейки на этом пути. Ячейки нумеруются построчно:
+   * id = row * cols + col.
    */
-  enum Wall {
-    NONE = 0b00,   ///< Стен нет
-    RIGHT = 0b01,  ///< Стена справа
-    DOWN = 0b10,   ///< Стена снизу
-    BOTH = 0b11    ///< Стены справа и снизу
+  struct DistanceField {
+    int rows = 0;               ///< Количество строк
+    int cols = 0;               ///< Количество столбцов
+    std::vector<int> distance;  ///< Расстояния, -1 у недостижимых ячеек
+    std::vector<int> parent;  ///< Родители, -1 у источников и недостижимых
+
+    /// Возвращает расстояние до ячейки или -1, если она недостижима
+    int distanceAt(int row, int col) const {
+      return distance[row * cols + col];
+    }
   };
 
   /**
-   * @struct Vertex
-   * @brief Структура вершины для создания списка смежности графа лабиринта.
-   * Одна вершина соответствует одной ячейке лабиринта.
+   * @struct Query
+   * @brief Запрос на поиск пути между двумя точками лабиринта
    */
-  struct Vertex {
-    int id;   ///< Уникальный номер вершины
-    int row;  ///< Номер строки
-    int col;  ///< Номер столбца
+  struct Query {
+    int row1;  ///< Строка точки старта
+    int col1;  ///< Столбец точки старта
+    int row2;  ///< Строка точки финиша
+    int col2;  ///< Столбец точки финиша
   };
 
   /**
@@ -45,6 +82,35 @@ class Maze {
    */
   Maze(int rows, int cols);
 
+  /**
+   * @brief Конструктор. Создает лабиринт поверх готовых стен без копирования.
+   * @param[in] grid стены лабиринта
+   */
+  explicit Maze(MazeGrid grid);
+
+  /**
+   * @brief Конструктор копирования
+   */
+  Maze(const Maze &other) = default;
+
+  /**
+   * @brief Конструктор перемещения. Объявлен явно, так как объявленный
+   * деструктор отключает неявное перемещение и возврат лабиринта по значению
+   * копировал бы все стены. Исходный лабиринт становится пустым.
+   */
+  Maze(Maze &&other) noexcept;
+
+  /**
+   * @brief Оператор присваивания копированием
+   */
+  Maze &operator=(const Maze &other) = default;
+
+  /**
+   * @brief Оператор присваивания перемещением. Исходный лабиринт становится
+   * пустым.
+   */
+  Maze &operator=(Maze &&other) noexcept;
+
   /**
    * @brief Деструктор
    */
@@ -54,40 +120,106 @@ class Maze {
    * @brief Возвращает количество столбцов в лабиринте
    * @return Количество столбцов
    */
-  int getCols();
+  int getCols() const;
 
   /**
    * @brief Возвращает количество строк в лабиринте
    * @return Количество строк
    */
-  int getRows();
+  int getRows() const;
 
   /**
    * @brief Проверяет, является ли лабиринт пустым
    * @return true, если лабиринт пустой, иначе false
    */
-  bool isEmpty();
+  bool isEmpty() const;
 
   // void print();
 
   /**
-   * @brief Возвращает матрицу стен лабиринта
-   * @return Матрица стен лабиринта
+   * @brief Возвращает невладеющее представление стен лабиринта без
+   * копирования. Представление действительно, пока жив лабиринт.
+   * @return Представление стен лабиринта
    */
-  std::vector<std::vector<int>> grid();
+  MazeGridView grid() const;
 
   /**
    * @brief Вычисляет решение лабиринта по заданным точкам с помощью алгоритма
    * обхода в ширину (BFS) и возвращает вектор пар (строка и столбец) координат
-   * пути
+   * пути. Соседи ячеек вычисляются напрямую по битам стен, без построения
+   * списка смежности. Рабочая память поиска своя у каждого потока и
+   * переиспользуется между вызовами.
    * @param[in] row1 строка точки старта
    * @param[in] col1 столбец точки старта
    * @param[in] row2 строка точки финиша
    * @param[in] col2 столбец точки финиша
+   * @param[in] method алгоритм поиска пути
    * @return Координаты пути
    */
-  std::vector<std::pair<int, int>> getSolution(int row1, int col1, int row2,
-                                               int col2);
+  std::vector<std::pair<int, int>> getSolution(
+      int row1, int col1, int row2, int col2,
+      SolveMethod method = SolveMethod::BFS) const;
+
+  /**
+   * @brief Вычисляет решение лабиринта по заданным точкам, используя внешнюю
+   * рабочую память. Повторные вызовы с той же рабочей памятью не выделяют
+   * память.
+   * @param[in] row1 строка точки старта
+   * @param[in] col1 столбец точки старта
+   * @param[in] row2 строка точки финиша
+   * @param[in] col2 столбец точки финиша
+   * @param[in,out] workspace рабочая память поиска
+   * @param[in] method алгоритм поиска пути
+   * @return Координаты пути
+   */
+  std::vector<std::pair<int, int>> getSolution(
+      int row1, int col1, int row2, int col2, SolverWorkspace &workspace,
+      SolveMethod method = SolveMethod::BFS) const;
+
+  /**
+   * @brief Решает набор запросов параллельно. Запросы распределяются между
+   * потоками, у каждого потока своя рабочая память, стены лабиринта
+   * используются совместно только для чтения.
+   * @param[in] queries запросы на поиск пути
+   * @param[in] method алгоритм поиска пути
+   * @param[in] threads количество потоков, 0 - по числу ядер процессора
+   * @return Пути в порядке запросов
+   */
+  std::vector<std::vector<std::pair<int, int>>> solveBatch(
+      std::span<const Query> queries, SolveMethod method = SolveMethod::BFS,
+      int threads = 0) const;
+
+  /**
+   * @brief Вычисляет за один обход в ширину расстояния от источников до всех
+   * ячеек лабиринта. При нескольких источниках каждая ячейка получает
+   * расстояние до ближайшего из них, а цепочка родителей ведет к нему.
+   * @param[in] sources координаты источников (строка и столбец), некорректные
+   * координаты пропускаются
+   * @return Поле расстояний; пустое, если лабиринт пустой
+   */
+  DistanceField getDistanceField(
+      const std::vector<std::pair<int, int>> &sources) const;
+
+  /**
+   * @brief Строит индекс дерева для быстрых запросов пути, если он еще не
+   * построен. Построение выполняется ровно один раз, даже если индекс
+   * запрашивают одновременно несколько потоков. Индекс отражает стены на
+   * момент построения.
+   * @return true, если лабиринт идеальный и индекс доступен
+   */
+  bool buildTreeIndex() const;
+
+  /**
+   * @brief Вычисляет длину пути (количество шагов) между двумя точками. Для
+   * идеального лабиринта использует индекс дерева и не обходит лабиринт,
+   * иначе выполняет поиск в ширину.
+   * @param[in] row1 строка точки старта
+   * @param[in] col1 столбец точки старта
+   * @param[in] row2 строка точки финиша
+   * @param[in] col2 столбец точки финиша
+   * @return Длина пути или -1, если пути нет или точки некорректны
+   */
+  int getPathLength(int row1, int col1, int row2, int col2) const;
 
 #ifdef TEST
  public:
@@ -96,15 +228,43 @@ class Maze {
 #endif
 
   /**
-   * @brief Индексирует вершины лабиринта
+   * @class LazyTreeIndex
+   * @brief Индекс дерева, который строится при первом обращении под защитой
+   * std::call_once. При копировании лабиринта индекс не копируется и будет
+   * построен заново для копии. При перемещении индекс переходит к новому
+   * объекту, а исходный получает пустое состояние и остается пригодным.
    */
-  void indexVertices();
+  class LazyTreeIndex {
+   public:
+    LazyTreeIndex() : state_(std::make_unique<State>()) {}
+    LazyTreeIndex(const LazyTreeIndex &) : LazyTreeIndex() {}
+    LazyTreeIndex(LazyTreeIndex &&other) noexcept
+        : state_(std::exchange(other.state_, std::make_unique<State>())) {}
+    LazyTreeIndex &operator=(const LazyTreeIndex &) {
+      state_ = std::make_unique<State>();
+      return *this;
+    }
+    LazyTreeIndex &operator=(LazyTreeIndex &&other) noexcept {
+      if (this != &other)
+        state_ = std::exchange(other.state_, std::make_unique<State>());
+      return *this;
+    }
 
-  /**
-   * @brief Генерирует список смежности по вершинам лабиринта, учитывая наличие
-   * стен
-   */
-  void generateGraph();
+    /// Возвращает индекс, при первом вызове строит его по стенам лабиринта
+    const MazeTreeIndex &get(const MazeGrid &grid) const {
+      std::call_once(state_->once, [&]() { state_->index.build(grid); });
+      return state_->index;
+    }
+
+   private:
+    /// Флаг однократного построения и сам индекс
+    struct State {
+      std::once_flag once;
+      MazeTreeIndex index;
+    };
+    /// состояние индекса
+    std::unique_ptr<State> state_;
+  };
 
   /**
    * @brief Проверяет, являются ли указанные координаты допустимыми точками в
@@ -115,18 +275,64 @@ class Maze {
    * @param[in] y2 столбец точки финиша
    * @return true, если точки корректные, иначе false
    */
-  bool isValidPoints(int x1, int y1, int x2, int y2);
+  bool isValidPoints(int x1, int y1, int x2, int y2) const;
+
+  /**
+   * @brief Ищет путь обходом в ширину от точки старта
+   * @param[in] start_id номер ячейки старта
+   * @param[in] finish_id номер ячейки финиша
+   * @param[in,out] workspace рабочая память поиска
+   * @return Координаты пути или пустой вектор, если пути нет
+   */
+  std::vector<std::pair<int, int>> solveBfs(int start_id, int finish_id,
+                                            SolverWorkspace &workspace) const;
+
+  /**
+   * @brief Ищет путь встречным обходом в ширину. На каждом шаге раскрывается
+   * целиком уровень меньшего из двух фронтов, путь склеивается в точке их
+   * встречи из родителей обоих фронтов.
+   * @param[in] start_id номер ячейки старта
+   * @param[in] finish_id номер ячейки финиша
+   * @param[in,out] workspace рабочая память поиска
+   * @return Координаты пути или пустой вектор, если пути нет
+   */
+  std::vector<std::pair<int, int>> solveBidirectional(
+      int start_id, int finish_id, SolverWorkspace &workspace) const;
+
+  /**
+   * @brief Ищет путь алгоритмом A* с манхэттенской эвристикой. Подходит для
+   * лабиринтов с петлями и открытыми областями, где раскрывает заметно меньше
+   * ячеек, чем обход в ширину.
+   * @tparam Queue тип очереди с приоритетом (HeapQueue или BucketQueue)
+   * @param[in] start_id номер ячейки старта
+   * @param[in] finish_id номер ячейки финиша
+   * @param[in,out] workspace рабочая память поиска
+   * @param[in,out] queue очередь открытого списка
+   * @return Координаты пути или пустой вектор, если пути нет
+   */
+  template <typename Queue>
+  std::vector<std::pair<int, int>> solveAStar(int start_id, int finish_id,
+                                              SolverWorkspace &workspace,
+                                              Queue &queue) const;
+
+  /**
+   * @brief Добавляет в путь координаты цепочки ячеек от указанной ячейки по
+   * родителям до начальной точки её фронта
+   * @param[in] id номер ячейки
+   * @param[in] workspace рабочая память поиска
+   * @param[in,out] path путь
+   */
+  void tracePath(int id, const SolverWorkspace &workspace,
+                 std::vector<std::pair<int, int>> &path) const;
 
   /// количество строк в лабиринте
   int rows_;
   /// количество столбцов в лабиринте
   int cols_;
-  /// матрица стен лабиринта
-  std::vector<std::vector<int>> grid_;
-  /// матрица вершин лабиринта
-  std::vector<std::vector<Vertex>> vertices_;
-  /// представление лабиринта в виде списка смежности графа
-  std::vector<std::vector<int>> graph_;
+  /// битовое хранилище стен лабиринта
+  MazeGrid grid_;
+  /// индекс дерева для идеального лабиринта, строится по требованию
+  LazyTreeIndex tree_index_;
 };
 
 #endif  // MAZE_H
\ No newline at end of file
@@ -1,15 +1,28 @@
 #ifndef MAZE_BUILDER_H
 #define MAZE_BUILDER_H
 
-#ifdef _WIN32
-#include <time.h>
-#include <windows.h>
-#else
-#include <sys/time.h>
-#include <unistd.h>
-#endif
+#include <cstdint>
 
 #include "maze.h"
+#include "maze_random.h"
+
+/**
+ * @struct MazeDescriptor
+ * @brief Описание сгенерированного лабиринта: по алгоритму, размерам и зерну
+ * лабиринт генерируется заново, поэтому вместо стен достаточно хранить
+ * описание. Занимает 32 байта.
+ */
+struct MazeDescriptor {
+  std::uint32_t version;    ///< Версия генераторов MazeBuilder
+  std::uint32_t algorithm;  ///< Алгоритм генерации MazeBuilder::Algorithm
+  std::int32_t rows;        ///< Количество строк
+  std::int32_t cols;        ///< Количество столбцов
+  std::uint64_t seed;       ///< Зерно лабиринта
+  std::uint32_t flags;      ///< Флаги генерации
+  std::uint32_t reserved;   ///< Резерв, заполняется нулями
+};
+
+static_assert(sizeof(MazeDescriptor) == 32, "descriptor must take 32 bytes");
 
 /**
  * @class MazeBuilder
@@ -18,72 +31,372 @@
 class MazeBuilder {
  public:
   /**
-   * @brief Конструктор по умолчанию
+   * @enum Kernel
+   * @brief Способ расстановки стен в строке. Для одного зерна все способы
+   * дают одинаковый лабиринт.
+   */
+  enum Kernel {
+    SCALAR = 0,       ///< По одной ячейке
+    BIT_PARALLEL = 1  ///< Словами по 64 ячейки
+  };
+
+  /**
+   * @enum Algorithm
+   * @brief Алгоритм генерации лабиринта. Все алгоритмы дают идеальный
+   * лабиринт, но с разной текстурой.
+   */
+  enum Algorithm {
+    ELLER = 0,        ///< Алгоритм Эллера: построчно, O(cols) памяти
+    SIDEWINDER = 1,   ///< Sidewinder: строки независимы, длинный коридор снизу
+    BINARY_TREE = 2,  ///< Двоичное дерево: строки независимы, самый быстрый
+    WILSON = 3,       ///< Алгоритм Уилсона: равномерно случайное дерево
+    KRUSKAL = 4       ///< Случайный алгоритм Краскала
+  };
+
+  /// Количество строк в полосе параллельной генерации
+  constexpr static int STRIP_ROWS = 256;
+  /// Версия генераторов. Увеличивается при любом изменении, после которого
+  /// то же зерно дает другой лабиринт.
+  constexpr static std::uint32_t GENERATOR_VERSION = 1;
+  /// Флаг описания: лабиринт сгенерирован полосами (createMazeParallel)
+  constexpr static std::uint32_t FLAG_STRIPS = 0x1;
+
+  /**
+   * @brief Конструктор по умолчанию. Зерна лабиринтов выбираются случайно.
    */
   MazeBuilder();
 
+  /**
+   * @brief Конструктор. Последовательность зерен лабиринтов, а значит и сами
+   * лабиринты, определяется указанным зерном.
+   * @param[in] seed зерно построителя
+   */
+  explicit MazeBuilder(std::uint64_t seed);
+
   /**
    * @brief Деструктор
    */
   ~MazeBuilder() = default;
 
   /**
-   * @brief Генерирует лабиринт заданных размеров по алгоритму Эллера
+   * @brief Генерирует лабиринт заданных размеров выбранным алгоритмом
    * @param[in] rows количество строк
    * @param[in] cols количество столбцов
    * @return экземпляр класса лабиринта
    */
   Maze createMaze(int rows, int cols);
 
+  /**
+   * @brief Генерирует лабиринт заданных размеров выбранным алгоритмом из
+   * зерна. Одинаковые алгоритм, размеры и зерно всегда дают одинаковый
+   * лабиринт.
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] seed зерно лабиринта
+   * @return экземпляр класса лабиринта
+   */
+  Maze createMaze(int rows, int cols, std::uint64_t seed);
+
+  /**
+   * @brief Генерирует лабиринт из зерна параллельно. Лабиринт делится на
+   * горизонтальные полосы по STRIP_ROWS строк, каждая полоса - отдельный
+   * идеальный лабиринт со своим зерном, полученным из общего. Соседние полосы
+   * соединяются одним проходом в столбце, выбранном по зерну, поэтому
+   * результат - тоже идеальный лабиринт. Лабиринт зависит только от размеров
+   * и зерна, но не от количества потоков.
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] seed зерно лабиринта
+   * @param[in] threads количество потоков, 0 - по числу ядер
+   * @return экземпляр класса лабиринта
+   */
+  Maze createMazeParallel(int rows, int cols, std::uint64_t seed,
+                          int threads = 0);
+
+  /**
+   * @brief Приемник готовых строк лабиринта, возврат false прерывает
+   * генерацию
+   */
+  using RowSink = MazeRowSink;
+
+  /**
+   * @brief Генерирует лабиринт выбранным алгоритмом построчно и передает
+   * каждую готовую строку приемнику. Для алгоритмов Эллера, Sidewinder и
+   * двоичного дерева хранится только текущая строка, поэтому память - O(cols)
+   * независимо от количества строк. Алгоритмам Уилсона и Краскала нужен
+   * весь лабиринт, они строят его целиком и затем передают по строкам.
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] sink приемник строк
+   * @return true, если приемник получил все строки, false при некорректных
+   * размерах или если приемник прервал генерацию
+   */
+  bool generate(int rows, int cols, const RowSink &sink);
+
+  /**
+   * @brief Генерирует лабиринт из зерна построчно и передает каждую готовую
+   * строку приемнику
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] seed зерно лабиринта
+   * @param[in] sink приемник строк
+   * @return true, если приемник получил все строки, иначе false
+   */
+  bool generate(int rows, int cols, std::uint64_t seed, const RowSink &sink);
+
+  /**
+   * @brief Генерирует из зерна только диапазон строк лабиринта и передает
+   * их приемнику. Строки Sidewinder и двоичного дерева зависят только от
+   * своих зерен и строятся сразу. Алгоритму Эллера нужны все строки выше
+   * диапазона, но они не передаются и не хранятся. Алгоритмы Уилсона и
+   * Краскала строят весь лабиринт.
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] seed зерно лабиринта
+   * @param[in] first_row первая строка диапазона
+   * @param[in] count количество строк диапазона
+   * @param[in] sink приемник строк
+   * @return true, если приемник получил все строки диапазона, иначе false
+   */
+  bool generate(int rows, int cols, std::uint64_t seed, int first_row,
+                int count, const RowSink &sink);
+
+  /**
+   * @brief Составляет описание лабиринта для выбранного алгоритма
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] seed зерно лабиринта
+   * @param[in] strips true, если лабиринт сгенерирован createMazeParallel
+   * @return Описание лабиринта
+   */
+  MazeDescriptor describe(int rows, int cols, std::uint64_t seed,
+                          bool strips = false) const;
+
+  /**
+   * @brief Проверяет, что лабиринт можно сгенерировать по описанию этой
+   * версией генераторов и что количество ячеек не превышает
+   * MazeGrid::MAX_CELLS
+   * @param[in] descriptor описание лабиринта
+   * @return true, если описание корректно
+   */
+  static bool isValid(const MazeDescriptor &descriptor);
+
+  /**
+   * @brief Генерирует лабиринт по описанию. Выбирает алгоритм описания.
+   * @param[in] descriptor описание лабиринта
+   * @return экземпляр класса лабиринта, пустой при некорректном описании
+   */
+  Maze createMaze(const MazeDescriptor &descriptor);
+
+  /**
+   * @brief Генерирует по описанию только диапазон строк лабиринта. Для
+   * лабиринта из полос генерируются только полосы, пересекающие диапазон.
+   * Выбирает алгоритм описания.
+   * @param[in] descriptor описание лабиринта
+   * @param[in] first_row первая строка диапазона
+   * @param[in] count количество строк диапазона
+   * @param[in] sink приемник строк
+   * @return true, если приемник получил все строки диапазона, иначе false
+   */
+  bool generate(const MazeDescriptor &descriptor, int first_row, int count,
+                const RowSink &sink);
+
+  /**
+   * @brief Возвращает зерно последнего сгенерированного лабиринта. По нему
+   * лабиринт можно сгенерировать заново вместо хранения стен.
+   * @return Зерно лабиринта
+   */
+  std::uint64_t lastSeed() const { return last_seed_; }
+
+  /**
+   * @brief Выбирает алгоритм генерации
+   * @param[in] algorithm алгоритм генерации
+   */
+  void setAlgorithm(Algorithm algorithm) { algorithm_ = algorithm; }
+
+  /**
+   * @brief Возвращает алгоритм генерации
+   * @return Алгоритм генерации
+   */
+  Algorithm algorithm() const { return algorithm_; }
+
+  /**
+   * @brief Выбирает способ расстановки стен в строке алгоритма Эллера
+   * @param[in] kernel способ расстановки стен
+   */
+  void setKernel(Kernel kernel) { kernel_ = kernel; }
+
+  /**
+   * @brief Возвращает способ расстановки стен в строке
+   * @return Способ расстановки стен
+   */
+  Kernel kernel() const { return kernel_; }
+
  private:
   /**
-   * @brief Если ячейка лабиринта не входит ни в одно множество, то
-   * присваивает ей новое уникальное множество
-   * @param[in] line ссылка на текущую строку лабиринта
+   * @brief Выбирает случайные биты решений о стенах текущей строки: по
+   * одному биту на ячейку для правых и для нижних стен, 64 бита за вызов
+   * генератора
    */
-  void assignUniqueSet(std::vector<int> &line);
+  void drawRowBits();
 
   /**
-   * @brief Генерирует у ячеек текущей строки стены справа
-   * @param[in] line ссылка на текущую строку лабиринта
-   * @param[in] cur_row номер текущей строки лабиринта
+   * @brief Возвращает бит ячейки из битовой строки
+   * @param[in] bits битовая строка
+   * @param[in] col столбец ячейки
+   * @return Значение бита
    */
-  void createRightWalls(std::vector<int> &line, int cur_row);
+  static int bitAt(const std::vector<std::uint64_t> &bits, int col) {
+    return (bits[col / MazeGrid::WORD_BITS] >> (col % MazeGrid::WORD_BITS)) & 1;
+  }
 
   /**
-   * @brief Объединяет ячейки двух множеств в одно
-   * @param[in] line ссылка на текущую строку лабиринта
-   * @param[in] set1 первое множество
-   * @param[in] set2 второе множество (присоединяется к первому)
+   * @brief Получает независимое зерно полосы или строки из зерна лабиринта
+   * @param[in] seed зерно лабиринта
+   * @param[in] index номер полосы или строки
+   * @return Производное зерно
    */
-  void mergeSets(std::vector<int> &line, int set1, int set2);
+  static std::uint64_t deriveSeed(std::uint64_t seed, int index);
 
   /**
-   * @brief Генерирует у ячеек текущей строки стены снизу
-   * @param[in] line ссылка на текущую строку лабиринта
+   * @brief Выбирает столбец прохода между полосой и следующей за ней
+   * @param[in] seed зерно лабиринта
+   * @param[in] strip номер полосы
+   * @param[in] cols количество столбцов
+   * @return Столбец прохода
+   */
+  static int stripPassage(std::uint64_t seed, int strip, int cols);
+
+  /**
+   * @brief Создает строитель для генерации по описанию: с алгоритмом
+   * описания и ядром этого строителя, настройки которого не меняются
+   * @param[in] descriptor описание лабиринта
+   * @return Строитель
+   */
+  MazeBuilder descriptorBuilder(const MazeDescriptor &descriptor) const;
+
+  /**
+   * @brief Генерирует очередную строку по алгоритму Эллера. Перед каждой
+   * строкой, кроме первой, очищает стены предыдущей.
    * @param[in] cur_row номер текущей строки лабиринта
    */
-  void createDownWalls(std::vector<int> &line, int cur_row);
+  void createEllerRow(int cur_row);
 
   /**
-   * @brief Подсчитывает количество ячеек без нижней стены в указанном множестве
-   * @param[in] line ссылка на текущую строку лабиринта
-   * @param[in] set множество
+   * @brief Генерирует строку по алгоритму Sidewinder. Строка разбивается на
+   * отрезки случайными стенами справа, каждый отрезок соединяется со строкой
+   * ниже через одну случайную ячейку. Последняя строка - сплошной коридор.
+   * Строка зависит только от своего производного зерна.
    * @param[in] cur_row номер текущей строки лабиринта
-   * @return количество ячеек без нижней стены
    */
-  int countAvailableCells(std::vector<int> &line, int set, int cur_row);
+  void createSidewinderRow(int cur_row);
 
   /**
-   * @brief Удаляет стены у ячеек текущей строки и присваивает им
-   * пустое множество. Используется при добавлении строк в лабиринт.
-   * @param[in] line ссылка на текущую строку лабиринта
+   * @brief Генерирует строку по алгоритму двоичного дерева: каждая ячейка
+   * открывает проход либо вправо, либо вниз. Строка зависит только от своего
+   * производного зерна и строится словами по 64 ячейки.
    * @param[in] cur_row номер текущей строки лабиринта
    */
-  void deleteWalls(std::vector<int> &line, int cur_row);
+  void createBinaryTreeRow(int cur_row);
+
+  /**
+   * @brief Генерирует весь лабиринт алгоритмом Уилсона: случайные блуждания
+   * со стиранием петель присоединяют ячейки к растущему дереву
+   * @param[out] grid стены лабиринта
+   */
+  void createWilson(MazeGrid &grid);
+
+  /**
+   * @brief Генерирует весь лабиринт случайным алгоритмом Краскала: стены
+   * перебираются в случайном порядке и удаляются, если разделяют разные
+   * множества
+   * @param[out] grid стены лабиринта
+   */
+  void createKruskal(MazeGrid &grid);
+
+  /**
+   * @brief Удаляет стену между соседними ячейками
+   * @param[out] grid стены лабиринта
+   * @param[in] a номер первой ячейки
+   * @param[in] b номер второй ячейки
+   */
+  void removeWallBetween(MazeGrid &grid, int a, int b) const;
 
   /**
-   * @brief Очищает текущий лабиринт и устанавливает параметры для нового.
+   * @brief Выбирает случайное число из диапазона [0, bound)
+   * @param[in] bound граница диапазона
+   * @return Случайное число
+   */
+  int randomBelow(int bound) {
+    return static_cast<int>(random_.next() % static_cast<unsigned>(bound));
+  }
+
+  /**
+   * @brief Возвращает маску ячеек слова строки с номерами меньше count
+   * @param[in] word номер слова
+   * @param[in] count количество ячеек
+   * @return Маска ячеек
+   */
+  static std::uint64_t wordMask(int word, int count) {
+    int bits = count - word * MazeGrid::WORD_BITS;
+    if (bits >= MazeGrid::WORD_BITS) return ~std::uint64_t{0};
+    return bits <= 0 ? 0 : (std::uint64_t{1} << bits) - 1;
+  }
+
+  /**
+   * @brief Перенумеровывает множества текущей строки подряд с нуля и
+   * присваивает новое уникальное множество ячейкам, не входящим ни в одно.
+   * Номера множеств строки всегда меньше количества столбцов.
+   */
+  void assignUniqueSet();
+
+  /**
+   * @brief Генерирует у ячеек текущей строки стены справа
+   */
+  void createRightWalls();
+
+  /**
+   * @brief Находит представителя множества (корень в системе непересекающихся
+   * множеств) и сокращает путь к нему
+   * @param[in] set множество
+   * @return представитель множества
+   */
+  int findSet(int set);
+
+  /**
+   * @brief Объединяет два множества в одно за почти O(1)
+   * @param[in] set1 первое множество
+   * @param[in] set2 второе множество
+   */
+  void mergeSets(int set1, int set2);
+
+  /**
+   * @brief Генерирует у ячеек текущей строки стены снизу
+   */
+  void createDownWalls();
+
+  /**
+   * @brief Генерирует стены справа словами: ячейки с битом стены получают
+   * стену одной операцией на слово, по отдельности обрабатываются только
+   * кандидаты на проход
+   */
+  void createRightWallsBitwise();
+
+  /**
+   * @brief Генерирует стены снизу словами: по отдельности обрабатываются
+   * только ячейки с битом стены
+   */
+  void createDownWallsBitwise();
+
+  /**
+   * @brief Удаляет стены текущей строки, чтобы использовать её как следующую.
+   * Ячейки под нижними стенами получают пустое множество.
+   */
+  void deleteWalls();
+
+  /**
+   * @brief Очищает состояние генерации и устанавливает параметры нового
+   * лабиринта.
    * @param[in] rows количество строк
    * @param[in] cols количество столбцов
    */
@@ -92,19 +405,41 @@ class MazeBuilder {
   /**
    * @brief Обрабатывает последнюю строку лабиринта - выборочно удаляет стены
    * справа и добавляет стены снизу всей строке.
-   * @param[in] line ссылка на текущую строку лабиринта
-   * @param[in] cur_row номер текущей строки лабиринта
    */
-  void handleLastLine(std::vector<int> &line, int cur_row);
+  void handleLastLine();
+
+  /// пустое множество - ячейка еще не входит ни в одно множество
+  constexpr static int NO_SET = -1;
 
   /// количество строк
   int rows_;
   /// количество столбцов
   int cols_;
-  /// счетчик множеств
-  int set_counter_;
-  /// экземпляр класса лабиринта
-  Maze maze_;
+  /// множества ячеек текущей строки
+  std::vector<int> line_;
+  /// родители множеств в системе непересекающихся множеств
+  std::vector<int> set_parent_;
+  /// для представителя: количество ячеек множества в строке без стены снизу.
+  /// До расстановки нижних стен совпадает с размером множества.
+  std::vector<int> open_cells_;
+  /// новые номера множеств при перенумерации строки
+  std::vector<int> set_remap_;
+  /// стены текущей строки
+  MazeGrid line_walls_;
+  /// биты решений о правых стенах текущей строки, 1 - поставить стену
+  std::vector<std::uint64_t> right_bits_;
+  /// биты решений о нижних стенах текущей строки, 1 - попытаться поставить
+  std::vector<std::uint64_t> down_bits_;
+  /// генератор зерен лабиринтов
+  MazeRandom seeds_;
+  /// генератор решений о стенах текущего лабиринта
+  MazeRandom random_;
+  /// зерно последнего лабиринта
+  std::uint64_t last_seed_;
+  /// способ расстановки стен в строке
+  Kernel kernel_;
+  /// алгоритм генерации
+  Algorithm algorithm_;
 };
 
 #endif  // MAZE_BUILDER_H
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef MAZE_CODEC_H
+#define MAZE_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "maze_grid.h"
+
+/**
+ * @class MazeCodec
+ * @brief Сжатие стен лабиринта блоками строк.
+ *
+ * Биты стен кодируются адаптивным двоичным арифметическим кодером (range
+ * coder). Вероятность каждого бита оценивается по контексту - уже
+ * закодированным соседним стенам той же и предыдущей строки, поэтому
+ * характерная для идеальных лабиринтов структура сжимается в несколько раз.
+ * Каждый блок кодируется с чистой моделью и без ссылок на другие блоки, так
+ * что блоки декодируются независимо и в любом порядке.
+ */
+class MazeCodec {
+ public:
+  /**
+   * @brief Кодирует блок строк
+   * @param[in] grid стены лабиринта
+   * @param[in] first_row первая строка блока
+   * @param[in] count количество строк блока
+   * @return Сжатые данные блока
+   */
+  static std::vector<std::uint8_t> encodeRows(MazeGridView grid, int first_row,
+                                              int count);
+
+  /**
+   * @brief Кодирует блок строк, переданный отдельным хранилищем. Результат
+   * совпадает с encodeRows для тех же строк целого лабиринта, поэтому блок
+   * можно сжать, не держа в памяти остальные строки.
+   * @param[in] block стены строк блока
+   * @param[in] first_row номер первой строки блока в лабиринте
+   * @param[in] total_rows количество строк всего лабиринта
+   * @return Сжатые данные блока
+   */
+  static std::vector<std::uint8_t> encodeBlock(MazeGridView block,
+                                               int first_row, int total_rows);
+
+  /**
+   * @brief Декодирует блок строк
+   * @param[in] data сжатые данные блока
+   * @param[in] size размер сжатых данных в байтах
+   * @param[in] first_row номер первой строки блока в лабиринте
+   * @param[in] total_rows количество строк всего лабиринта
+   * @param[out] out стены блока, размеры задают количество строк и столбцов
+   * @return true, если декодер прочитал ровно size байт. Обрезанные или
+   * испорченные данные обычно сбиваются с этого счета, но надежно их
+   * находит только контрольная сумма.
+   */
+  static bool decodeRows(const std::uint8_t *data, std::size_t size,
+                         int first_row, int total_rows, MazeGrid &out);
+};
+
+#endif  // MAZE_CODEC_H
@@ -0,0 +1,108 @@
+#ifndef MAZE_COMPRESSED_WRITER_H
+#define MAZE_COMPRESSED_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "maze_grid.h"
+#include "maze_serializer.h"
+
+/**
+ * @class MazeCompressedWriter
+ * @brief Построчная запись сжатого файла лабиринта (формат "MAZECMP").
+ *
+ * Строки принимаются по порядку, например из MazeBuilder::generate, и
+ * копятся до заполнения блока, который сразу сжимается и пишется в файл.
+ * В памяти находится только текущий блок, поэтому можно записать лабиринт,
+ * который не помещается в память целиком. Место под заголовок и таблицу
+ * смещений резервируется в начале файла, а заполняется в finish вместе с
+ * контрольной суммой, которая считается по мере поступления строк. Пока
+ * finish не вызван, заголовок состоит из нулей и файл не читается.
+ */
+class MazeCompressedWriter {
+ public:
+  /**
+   * @brief Конструктор. Открывает файл для записи.
+   * @param[in] file_path путь к файлу
+   * @param[in] rows количество строк лабиринта
+   * @param[in] cols количество столбцов лабиринта
+   * @param[in] seed зерно лабиринта, если оно известно
+   * @param[in] block_rows количество строк в блоке
+   */
+  MazeCompressedWriter(
+      const std::string file_path, int rows, int cols,
+      std::optional<std::uint64_t> seed = {},
+      int block_rows = MazeSerializer::COMPRESSED_BLOCK_ROWS);
+
+  MazeCompressedWriter(const MazeCompressedWriter &) = delete;
+  MazeCompressedWriter &operator=(const MazeCompressedWriter &) = delete;
+
+  /**
+   * @brief Деструктор. Закрывает файл; без вызова finish файл остается
+   * незавершенным.
+   */
+  ~MazeCompressedWriter() = default;
+
+  /**
+   * @brief Проверяет, что файл открыт и ошибок записи не было
+   * @return true, если запись возможна
+   */
+  bool isOpen() const { return !failed_; }
+
+  /**
+   * @brief Принимает очередную строку лабиринта
+   * @param[in] row номер строки, строки передаются по порядку с нулевой
+   * @param[in] line стены строки: представление из одной строки
+   * @return true, если строка записана; false при ошибке записи, нарушении
+   * порядка строк или несовпадении ширины
+   */
+  bool append(int row, MazeGridView line);
+
+  /**
+   * @brief Возвращает приемник строк, передающий строки в append
+   * @return Приемник строк, действительный, пока существует писатель
+   */
+  MazeRowSink sink();
+
+  /**
+   * @brief Дописывает последний блок, заголовок и таблицу смещений
+   * @return true, если получены все строки и файл записан
+   */
+  bool finish();
+
+ private:
+  /**
+   * @brief Сжимает накопленные строки блока и пишет их в файл
+   */
+  void writeBlock();
+
+  /// файл лабиринта
+  std::ofstream file_;
+  /// путь к файлу для сообщений об ошибках
+  std::string file_path_;
+  /// количество строк лабиринта
+  int rows_;
+  /// количество столбцов лабиринта
+  int cols_;
+  /// зерно лабиринта, если оно известно
+  std::optional<std::uint64_t> seed_;
+  /// количество строк в блоке
+  int block_rows_;
+  /// строки текущего блока
+  MazeGrid block_;
+  /// номер следующей ожидаемой строки
+  int next_row_;
+  /// смещения записанных блоков от начала файла
+  std::vector<std::uint64_t> offsets_;
+  /// смещение конца записанных данных
+  std::uint64_t offset_;
+  /// контрольная сумма полученных строк
+  std::uint64_t checksum_;
+  /// произошла ошибка, файл не будет завершен
+  bool failed_;
+};
+
+#endif  // MAZE_COMPRESSED_WRITER_H
@@ -0,0 +1,399 @@
+#ifndef MAZE_GRID_H
+#define MAZE_GRID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+class MazeGridView;
+
+/**
+ * @class MazeGrid
+ * @brief Компактное хранилище стен лабиринта.
+ *
+ * Для каждой строки хранятся две битовые плоскости - стены справа и стены
+ * снизу, по одному биту на ячейку. Строка каждой плоскости выровнена на
+ * 64-битные слова, все строки лежат в одном непрерывном буфере в порядке
+ * [строка 0: правые | строка 0: нижние | строка 1: правые | ...], поэтому
+ * проход по строке лабиринта - последовательное чтение памяти.
+ *
+ * Буфер принадлежит хранилищу либо является внешним (например, отображенным
+ * в память файлом) и удерживается владельцем storage. Копия хранилища всегда
+ * получает собственный буфер.
+ *
+ * Размеры хранилища не ограничены, но лабиринт, который можно генерировать
+ * и решать, содержит не больше MAX_CELLS ячеек.
+ */
+class MazeGrid {
+ public:
+  /**
+   * @enum Wall
+   * @brief Определяет тип стены в ячейке лабиринта.
+   */
+  enum Wall {
+    NONE = 0b00,   ///< Стен нет
+    RIGHT = 0b01,  ///< Стена справа
+    DOWN = 0b10,   ///< Стена снизу
+    BOTH = 0b11    ///< Стены справа и снизу
+  };
+
+  /// Количество бит (ячеек) в одном слове хранилища
+  constexpr static int WORD_BITS = 64;
+
+  /// Наибольшее количество ячеек лабиринта. Генераторы и решатели нумеруют
+  /// ячейки числами int, алгоритм Краскала - и стены (2 * номер ячейки + 1)
+  constexpr static std::int64_t MAX_CELLS =
+      std::numeric_limits<int>::max() / 2;
+
+  /**
+   * @brief Конструктор пустого хранилища
+   */
+  MazeGrid();
+
+  /**
+   * @brief Конструктор. Все ячейки создаются без стен.
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   */
+  MazeGrid(int rows, int cols);
+
+  /**
+   * @brief Конструктор. Использует внешний буфер стен без копирования.
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] words буфер плоскостей стен в раскладке MazeGrid
+   * @param[in] storage владелец буфера, удерживается вместе с хранилищем
+   */
+  MazeGrid(int rows, int cols, std::uint64_t *words,
+           std::shared_ptr<void> storage);
+
+  /**
+   * @brief Конструктор копирования. Копирует стены в собственный буфер.
+   */
+  MazeGrid(const MazeGrid &other);
+
+  /**
+   * @brief Конструктор перемещения
+   */
+  MazeGrid(MazeGrid &&other) noexcept;
+
+  /**
+   * @brief Оператор присваивания копированием
+   */
+  MazeGrid &operator=(const MazeGrid &other);
+
+  /**
+   * @brief Оператор присваивания перемещением
+   */
+  MazeGrid &operator=(MazeGrid &&other) noexcept;
+
+  /**
+   * @brief Деструктор
+   */
+  ~MazeGrid() = default;
+
+  /**
+   * @brief Возвращает количество строк
+   * @return Количество строк
+   */
+  int rows() const { return rows_; }
+
+  /**
+   * @brief Возвращает количество столбцов
+   * @return Количество столбцов
+   */
+  int cols() const { return cols_; }
+
+  /**
+   * @brief Возвращает количество 64-битных слов в строке одной плоскости
+   * @return Количество слов
+   */
+  int wordsPerRow() const { return words_per_row_; }
+
+  /**
+   * @brief Проверяет, является ли хранилище пустым
+   * @return true, если в хранилище нет ячеек, иначе false
+   */
+  bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+  /**
+   * @brief Проверяет, использует ли хранилище внешний буфер
+   * @return true, если буфер внешний
+   */
+  bool isExternal() const { return storage_ != nullptr; }
+
+  /**
+   * @brief Проверяет наличие стены справа у ячейки
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @return true, если стена есть
+   */
+  bool hasRightWall(int row, int col) const;
+
+  /**
+   * @brief Проверяет наличие стены снизу у ячейки
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @return true, если стена есть
+   */
+  bool hasDownWall(int row, int col) const;
+
+  /**
+   * @brief Возвращает стены ячейки в виде комбинации значений Wall
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @return Стены ячейки
+   */
+  int at(int row, int col) const;
+
+  /**
+   * @brief Устанавливает стены ячейки
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @param[in] walls комбинация значений Wall
+   */
+  void set(int row, int col, int walls);
+
+  /**
+   * @brief Добавляет ячейке указанные стены
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @param[in] walls комбинация значений Wall
+   */
+  void addWalls(int row, int col, int walls);
+
+  /**
+   * @brief Удаляет у ячейки указанные стены
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @param[in] walls комбинация значений Wall
+   */
+  void removeWalls(int row, int col, int walls);
+
+  /**
+   * @brief Устанавливает всем ячейкам одинаковые стены
+   * @param[in] walls комбинация значений Wall
+   */
+  void fill(int walls);
+
+  /**
+   * @brief Находит соседей ячейки, в которые можно перейти без пересечения
+   * стен. Ячейки нумеруются построчно: id = row * cols + col.
+   * @param[in] row строка ячейки
+   * @param[in] col столбец ячейки
+   * @param[out] out массив для номеров соседей (не менее 4 элементов)
+   * @return Количество найденных соседей
+   */
+  int neighbors(int row, int col, int *out) const;
+
+  /**
+   * @brief Копирует стены одной строки в другую
+   * @param[in] from строка-источник
+   * @param[in] to строка-приемник
+   */
+  void copyRow(int from, int to);
+
+  /**
+   * @brief Копирует стены строки из другого хранилища той же ширины
+   * @param[in] source хранилище-источник
+   * @param[in] from строка источника
+   * @param[in] to строка-приемник
+   */
+  void copyRow(MazeGridView source, int from, int to);
+
+  /**
+   * @brief Возвращает указатель на слова плоскости правых стен строки
+   * @param[in] row номер строки
+   * @return Указатель на первое слово строки
+   */
+  std::uint64_t *rightRow(int row) {
+    return data_ + static_cast<std::size_t>(2 * row) * words_per_row_;
+  }
+
+  /// @copydoc rightRow(int)
+  const std::uint64_t *rightRow(int row) const {
+    return data_ + static_cast<std::size_t>(2 * row) * words_per_row_;
+  }
+
+  /**
+   * @brief Возвращает указатель на слова плоскости нижних стен строки
+   * @param[in] row номер строки
+   * @return Указатель на первое слово строки
+   */
+  std::uint64_t *downRow(int row) { return rightRow(row) + words_per_row_; }
+
+  /// @copydoc downRow(int)
+  const std::uint64_t *downRow(int row) const {
+    return rightRow(row) + words_per_row_;
+  }
+
+  /**
+   * @brief Возвращает объем памяти, занимаемый стенами
+   * @return Размер буфера в байтах
+   */
+  std::size_t sizeInBytes() const {
+    return wordCount() * sizeof(std::uint64_t);
+  }
+
+  /**
+   * @brief Возвращает невладеющее представление стен без копирования
+   * @return Представление стен
+   */
+  MazeGridView view() const;
+
+  /**
+   * @brief Неявно преобразует хранилище в представление без копирования
+   */
+  operator MazeGridView() const;
+
+  /**
+   * @brief Сравнивает размеры и стены двух хранилищ
+   */
+  bool operator==(const MazeGrid &other) const;
+
+ private:
+  /**
+   * @brief Возвращает количество слов в буфере стен
+   * @return Количество слов
+   */
+  std::size_t wordCount() const {
+    return static_cast<std::size_t>(2 * rows_) * words_per_row_;
+  }
+
+  /// количество строк
+  int rows_;
+  /// количество столбцов
+  int cols_;
+  /// количество слов в строке одной плоскости
+  int words_per_row_;
+  /// собственный буфер плоскостей стен всех строк
+  std::vector<std::uint64_t> words_;
+  /// используемый буфер: собственный или внешний
+  std::uint64_t *data_;
+  /// владелец внешнего буфера
+  std::shared_ptr<void> storage_;
+};
+
+/**
+ * @class MazeGridView
+ * @brief Невладеющее представление стен лабиринта только для чтения.
+ *
+ * Ссылается на буфер MazeGrid (или на другой буфер той же раскладки) и не
+ * копирует его, поэтому передается по значению. Представление действительно,
+ * пока жив и не изменен в размерах буфер, на который оно указывает.
+ */
+class MazeGridView {
+ public:
+  /**
+   * @brief Конструктор пустого представления
+   */
+  MazeGridView() = default;
+
+  /**
+   * @brief Конструктор
+   * @param[in] rows количество строк
+   * @param[in] cols количество столбцов
+   * @param[in] words_per_row количество слов в строке одной плоскости
+   * @param[in] words указатель на буфер плоскостей стен
+   */
+  MazeGridView(int rows, int cols, int words_per_row,
+               const std::uint64_t *words)
+      : rows_(rows),
+        cols_(cols),
+        words_per_row_(words_per_row),
+        words_(words) {}
+
+  /// @copydoc MazeGrid::rows
+  int rows() const { return rows_; }
+
+  /// @copydoc MazeGrid::cols
+  int cols() const { return cols_; }
+
+  /// @copydoc MazeGrid::wordsPerRow
+  int wordsPerRow() const { return words_per_row_; }
+
+  /// @copydoc MazeGrid::empty
+  bool empty() const { return rows_ == 0 || cols_ == 0; }
+
+  /// @copydoc MazeGrid::rightRow(int) const
+  const std::uint64_t *rightRow(int row) const {
+    return words_ + static_cast<std::size_t>(2 * row) * words_per_row_;
+  }
+
+  /// @copydoc MazeGrid::downRow(int) const
+  const std::uint64_t *downRow(int row) const {
+    return rightRow(row) + words_per_row_;
+  }
+
+  /// @copydoc MazeGrid::hasRightWall
+  bool hasRightWall(int row, int col) const {
+    std::uint64_t word = rightRow(row)[col / MazeGrid::WORD_BITS];
+    return (word >> (col % MazeGrid::WORD_BITS)) & 1;
+  }
+
+  /// @copydoc MazeGrid::hasDownWall
+  bool hasDownWall(int row, int col) const {
+    std::uint64_t word = downRow(row)[col / MazeGrid::WORD_BITS];
+    return (word >> (col % MazeGrid::WORD_BITS)) & 1;
+  }
+
+  /// @copydoc MazeGrid::at
+  int at(int row, int col) const {
+    return (hasRightWall(row, col) ? MazeGrid::RIGHT : MazeGrid::NONE) |
+           (hasDownWall(row, col) ? MazeGrid::DOWN : MazeGrid::NONE);
+  }
+
+  /// @copydoc MazeGrid::neighbors
+  int neighbors(int row, int col, int *out) const {
+    int id = row * cols_ + col;
+    int count = 0;
+    // слева, справа, сверху, снизу
+    if (col > 0 && !hasRightWall(row, col - 1)) out[count++] = id - 1;
+    if (col < cols_ - 1 && !hasRightWall(row, col)) out[count++] = id + 1;
+    if (row > 0 && !hasDownWall(row - 1, col)) out[count++] = id - cols_;
+    if (row < rows_ - 1 && !hasDownWall(row, col)) out[count++] = id + cols_;
+    return count;
+  }
+
+ private:
+  /// количество строк
+  int rows_ = 0;
+  /// количество столбцов
+  int cols_ = 0;
+  /// количество слов в строке одной плоскости
+  int words_per_row_ = 0;
+  /// буфер плоскостей стен
+  const std::uint64_t *words_ = nullptr;
+};
+
+/**
+ * @brief Приемник строк лабиринта. Получает номер строки и представление её
+ * стен из одной строки, действительное только во время вызова. Возврат false
+ * прерывает передачу строк.
+ */
+using MazeRowSink = std::function<bool(int row, MazeGridView line)>;
+
+inline MazeGridView MazeGrid::view() const {
+  return MazeGridView(rows_, cols_, words_per_row_, data_);
+}
+
+inline MazeGrid::operator MazeGridView() const { return view(); }
+
+inline bool MazeGrid::hasRightWall(int row, int col) const {
+  return view().hasRightWall(row, col);
+}
+
+inline bool MazeGrid::hasDownWall(int row, int col) const {
+  return view().hasDownWall(row, col);
+}
+
+inline int MazeGrid::at(int row, int col) const { return view().at(row, col); }
+
+inline int MazeGrid::neighbors(int row, int col, int *out) const {
+  return view().neighbors(row, col, out);
+}
+
+#endif  // MAZE_GRID_H
@@ -0,0 +1,74 @@
+#ifndef MAZE_RANDOM_H
+#define MAZE_RANDOM_H
+
+#include <bit>
+#include <cstdint>
+
+/**
+ * @class MazeRandom
+ * @brief Быстрый генератор псевдослучайных чисел xoshiro256** для генерации
+ * лабиринтов.
+ *
+ * Каждый вызов next() выдает 64 случайных бита, то есть 64 решения о стенах.
+ * Состояние генератора - четыре 64-битных слова, оно принадлежит экземпляру,
+ * поэтому генераторы разных потоков независимы. Одинаковое зерно дает
+ * одинаковую последовательность на любой платформе.
+ */
+class MazeRandom {
+ public:
+  /**
+   * @brief Конструктор
+   * @param[in] seed зерно генератора
+   */
+  explicit MazeRandom(std::uint64_t seed = 0) { reseed(seed); }
+
+  /**
+   * @brief Деструктор
+   */
+  ~MazeRandom() = default;
+
+  /**
+   * @brief Перезапускает генератор с новым зерном. Состояние заполняется
+   * генератором splitmix64, поэтому близкие зерна дают независимые
+   * последовательности.
+   * @param[in] seed зерно генератора
+   */
+  void reseed(std::uint64_t seed) {
+    for (std::uint64_t &word : state_) word = splitMix(seed);
+  }
+
+  /**
+   * @brief Выдает следующие 64 случайных бита
+   * @return Случайное 64-битное число
+   */
+  std::uint64_t next() {
+    std::uint64_t result = std::rotl(state_[1] * 5, 7) * 9;
+    std::uint64_t t = state_[1] << 17;
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = std::rotl(state_[3], 45);
+    return result;
+  }
+
+  /**
+   * @brief Шаг генератора splitmix64. Используется для заполнения состояния
+   * и для получения независимых зерен из одного.
+   * @param[in,out] x состояние splitmix64
+   * @return Случайное 64-битное число
+   */
+  static std::uint64_t splitMix(std::uint64_t &x) {
+    std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  }
+
+ private:
+  /// состояние генератора
+  std::uint64_t state_[4];
+};
+
+#endif  // MAZE_RANDOM_H
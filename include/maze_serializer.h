@@ -1,9 +1,46 @@
 #ifndef MAZE_SERIALIZER_H
 #define MAZE_SERIALIZER_H
 
+#include <cstdint>
 #include <fstream>
+#include <optional>
 
 #include "maze.h"
+#include "maze_builder.h"
+
+/**
+ * @struct MazeFileHeader
+ * @brief Заголовок двоичного файла лабиринта. Занимает 64 байта. Числа
+ * заголовка, таблицы смещений и слова стен хранятся в порядке little-endian
+ * и пишутся без преобразования, поэтому двоичные форматы читаются и пишутся
+ * только на little-endian платформах; на остальных MazeSerializer отвергает
+ * их с сообщением об ошибке.
+ *
+ * В несжатом файле (сигнатура "MAZEBIN") сразу за заголовком лежат плоскости
+ * стен в раскладке MazeGrid, поэтому файл можно отобразить в память и
+ * использовать как хранилище стен без разбора. В сжатом файле (сигнатура
+ * "MAZECMP") за заголовком идет таблица смещений блоков (количество блоков
+ * + 1 чисел uint64 от начала файла), а затем блоки по block_rows строк,
+ * сжатые MazeCodec независимо друг от друга. С флагом FLAG_BLOCK_CHECKSUMS
+ * каждый блок завершается контрольной суммой его строк (uint64), поэтому
+ * испорченный блок находится и при чтении части строк.
+ */
+struct MazeFileHeader {
+  char magic[8];               ///< Сигнатура формата с нулевым байтом
+  std::uint32_t version;       ///< Версия формата
+  std::uint32_t header_size;   ///< Размер заголовка в байтах
+  std::int32_t rows;           ///< Количество строк
+  std::int32_t cols;           ///< Количество столбцов
+  std::int32_t words_per_row;  ///< Количество слов в строке одной плоскости
+  std::uint32_t flags;         ///< Флаги файла
+  std::uint64_t seed;          ///< Зерно лабиринта, если оно известно
+  std::uint64_t payload_size;  ///< Размер данных после заголовка в байтах
+  std::uint64_t checksum;      ///< Контрольная сумма несжатых плоскостей стен
+  std::int32_t block_rows;     ///< Строк в сжатом блоке, 0 - без сжатия
+  std::uint8_t reserved[4];    ///< Резерв, заполняется нулями
+};
+
+static_assert(sizeof(MazeFileHeader) == 64, "header must take 64 bytes");
 
 /**
  * @class MazeSerializer
@@ -11,6 +48,24 @@
  */
 class MazeSerializer {
  public:
+  /// Сигнатура двоичного формата
+  constexpr static char BINARY_MAGIC[8] = "MAZEBIN";
+  /// Сигнатура сжатого двоичного формата
+  constexpr static char COMPRESSED_MAGIC[8] = "MAZECMP";
+  /// Сигнатура файла описания лабиринта
+  constexpr static char DESCRIPTOR_MAGIC[8] = "MAZEGEN";
+  /// Количество строк в блоке сжатого файла по умолчанию
+  constexpr static int COMPRESSED_BLOCK_ROWS = 256;
+  /// Текущая версия двоичного формата
+  constexpr static std::uint32_t BINARY_VERSION = 1;
+  /// Флаг заголовка: поле seed содержит зерно лабиринта
+  constexpr static std::uint32_t FLAG_HAS_SEED = 0x1;
+  /// Флаг заголовка сжатого файла: за данными каждого блока лежит
+  /// контрольная сумма его строк
+  constexpr static std::uint32_t FLAG_BLOCK_CHECKSUMS = 0x2;
+  /// Начальное значение контрольной суммы
+  constexpr static std::uint64_t CHECKSUM_BASIS = 0xcbf29ce484222325;
+
   /**
    * @brief Конструктор по умолчанию
    */
@@ -22,17 +77,146 @@ class MazeSerializer {
   ~MazeSerializer() = default;
 
   /**
-   * @brief Считывает лабиринт из файла по указанному пути
+   * @brief Считывает лабиринт из файла по указанному пути. Формат файла
+   * (текстовый, двоичный, сжатый или описание) определяется по сигнатуре.
+   * Контрольная сумма двоичного и сжатого файлов проверяется; чтобы открыть
+   * двоичный файл без чтения всех стен, используется readFromBinaryFile.
    * @param[in] file_path путь к файлу
    * @return экземпляр класса лабиринта
    */
   static Maze readFromFile(const std::string file_path);
 
   /**
-   * @brief Сохраняет лабиринт в файл по указанному пути
+   * @brief Сохраняет стены лабиринта в файл по указанному пути
+   * @param[in] grid представление стен лабиринта
+   * @param[in] file_path путь к файлу
+   */
+  static void saveToFile(MazeGridView grid, const std::string file_path);
+
+  /**
+   * @brief Считывает лабиринт из двоичного файла. Файл отображается в память
+   * и используется как хранилище стен без копирования; изменения стен не
+   * попадают в файл. Без поддержки отображения файл читается целиком.
+   * Сжатый файл распаковывается.
+   * @param[in] file_path путь к файлу
+   * @param[in] verify true - проверить контрольную сумму (читает весь файл)
+   * @return экземпляр класса лабиринта
+   */
+  static Maze readFromBinaryFile(const std::string file_path,
+                                 bool verify = false);
+
+  /**
+   * @brief Сохраняет стены лабиринта в двоичный файл
+   * @param[in] grid представление стен лабиринта
+   * @param[in] file_path путь к файлу
+   * @param[in] seed зерно лабиринта, если оно известно
+   */
+  static void saveToBinaryFile(MazeGridView grid, const std::string file_path,
+                               std::optional<std::uint64_t> seed = {});
+
+  /**
+   * @brief Сохраняет стены лабиринта в сжатый двоичный файл. Блоки строк
+   * сжимаются независимо, поэтому файл можно читать по частям. Чтобы
+   * записать лабиринт, не держа его в памяти целиком, используется
+   * MazeCompressedWriter.
+   * @param[in] grid представление стен лабиринта
+   * @param[in] file_path путь к файлу
+   * @param[in] seed зерно лабиринта, если оно известно
+   * @param[in] block_rows количество строк в блоке
+   */
+  static void saveToCompressedFile(MazeGridView grid,
+                                   const std::string file_path,
+                                   std::optional<std::uint64_t> seed = {},
+                                   int block_rows = COMPRESSED_BLOCK_ROWS);
+
+  /**
+   * @brief Считывает лабиринт из сжатого файла и проверяет контрольную сумму
+   * @param[in] file_path путь к файлу
+   * @return экземпляр класса лабиринта
+   */
+  static Maze readFromCompressedFile(const std::string file_path);
+
+  /**
+   * @brief Распаковывает диапазон строк сжатого файла и передает строки
+   * приемнику. Читаются и распаковываются только блоки, содержащие нужные
+   * строки, в памяти одновременно находится один блок. Каждый блок
+   * проверяется его контрольной суммой, если она записана, и по размеру
+   * сжатых данных; испорченный блок прерывает чтение до передачи его строк.
    * @param[in] file_path путь к файлу
+   * @param[in] first_row первая строка диапазона
+   * @param[in] count количество строк диапазона
+   * @param[in] sink приемник строк
+   * @return true, если приемник получил все строки диапазона
+   */
+  static bool readCompressedRows(const std::string file_path, int first_row,
+                                 int count, const MazeRowSink &sink);
+
+  /**
+   * @brief Сохраняет описание сгенерированного лабиринта. Файл занимает 40
+   * байт (сигнатура и MazeDescriptor) независимо от размеров лабиринта.
+   * @param[in] descriptor описание лабиринта
+   * @param[in] file_path путь к файлу
+   */
+  static void saveDescriptor(const MazeDescriptor &descriptor,
+                             const std::string file_path);
+
+  /**
+   * @brief Считывает и проверяет описание лабиринта
+   * @param[in] file_path путь к файлу
+   * @param[out] descriptor описание лабиринта
+   * @return true, если файл - корректное описание, которое можно
+   * сгенерировать этой версией MazeBuilder
+   */
+  static bool readDescriptor(const std::string file_path,
+                             MazeDescriptor &descriptor);
+
+  /**
+   * @brief Считывает описание лабиринта и генерирует лабиринт заново
+   * @param[in] file_path путь к файлу
+   * @return экземпляр класса лабиринта
+   */
+  static Maze readFromDescriptorFile(const std::string file_path);
+
+  /**
+   * @brief Считывает описание лабиринта и генерирует только диапазон строк
+   * (см. MazeBuilder::generate)
+   * @param[in] file_path путь к файлу
+   * @param[in] first_row первая строка диапазона
+   * @param[in] count количество строк диапазона
+   * @param[in] sink приемник строк
+   * @return true, если приемник получил все строки диапазона
+   */
+  static bool readDescriptorRows(const std::string file_path, int first_row,
+                                 int count, const MazeRowSink &sink);
+
+  /**
+   * @brief Считывает и проверяет заголовок двоичного или сжатого файла
+   * @param[in] file_path путь к файлу
+   * @param[out] header заголовок
+   * @return true, если файл - корректный двоичный файл лабиринта
+   */
+  static bool readBinaryHeader(const std::string file_path,
+                               MazeFileHeader &header);
+
+  /**
+   * @brief Проверяет, что порядок байт платформы совпадает с порядком байт
+   * двоичных форматов. Числа и слова стен пишутся и читаются (в том числе
+   * отображением в память) без преобразования, поэтому на big-endian
+   * платформах двоичные файлы не поддерживаются.
+   * @param[in] file_path путь к файлу для сообщения об ошибке
+   * @return true, если платформа little-endian
+   */
+  static bool isLittleEndianHost(const std::string &file_path);
+
+  /**
+   * @brief Вычисляет контрольную сумму стен (FNV-1a по 64-битным словам)
+   * @param[in] grid представление стен лабиринта
+   * @param[in] hash контрольная сумма предыдущих строк, позволяет считать
+   * сумму лабиринта по частям
+   * @return Контрольная сумма
    */
-  static void saveToFile(Maze maze, const std::string file_path);
+  static std::uint64_t checksum(MazeGridView grid,
+                                std::uint64_t hash = CHECKSUM_BASIS);
 };
 
-#endif  // MAZE_SERIALIZER_H
\ No newline at end of file
+#endif  // MAZE_SERIALIZER_H
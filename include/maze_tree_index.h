@@ -0,0 +1,111 @@
+#ifndef MAZE_TREE_INDEX_H
+#define MAZE_TREE_INDEX_H
+
+#include <utility>
+#include <vector>
+
+#include "maze_grid.h"
+
+/**
+ * @class MazeTreeIndex
+ * @brief Индекс для быстрых запросов пути в идеальном лабиринте.
+ *
+ * Идеальный лабиринт - это остовное дерево на ячейках, поэтому путь между
+ * двумя ячейками единственный и проходит через их наименьшего общего предка
+ * (LCA). Индекс один раз подвешивает дерево за ячейку (0, 0), строит эйлеров
+ * обход и разреженную таблицу минимумов глубины по блокам обхода. После этого
+ * длина пути вычисляется за O(log N), а сам путь восстанавливается за
+ * O(длина пути) без обхода всего лабиринта.
+ */
+class MazeTreeIndex {
+ public:
+  /// Количество элементов эйлерова обхода в одном блоке разреженной таблицы
+  constexpr static int BLOCK_SIZE = 64;
+
+  /**
+   * @brief Конструктор пустого индекса
+   */
+  MazeTreeIndex();
+
+  /**
+   * @brief Конструктор. Строит индекс по стенам лабиринта.
+   * @param[in] grid стены лабиринта
+   */
+  explicit MazeTreeIndex(MazeGridView grid);
+
+  /**
+   * @brief Деструктор
+   */
+  ~MazeTreeIndex() = default;
+
+  /**
+   * @brief Строит индекс по стенам лабиринта
+   * @param[in] grid стены лабиринта
+   * @return true, если лабиринт идеальный и индекс построен, иначе false
+   */
+  bool build(MazeGridView grid);
+
+  /**
+   * @brief Проверяет, построен ли индекс
+   * @return true, если индекс построен
+   */
+  bool isValid() const { return !parent_.empty(); }
+
+  /**
+   * @brief Находит наименьшего общего предка двух ячеек
+   * @param[in] from номер первой ячейки
+   * @param[in] to номер второй ячейки
+   * @return Номер ячейки-предка
+   */
+  int lca(int from, int to) const;
+
+  /**
+   * @brief Вычисляет длину пути (количество шагов) между двумя ячейками
+   * @param[in] from номер ячейки старта
+   * @param[in] to номер ячейки финиша
+   * @return Длина пути или -1, если индекс не построен
+   */
+  int pathLength(int from, int to) const;
+
+  /**
+   * @brief Восстанавливает путь между двумя ячейками
+   * @param[in] from номер ячейки старта
+   * @param[in] to номер ячейки финиша
+   * @return Координаты пути или пустой вектор, если индекс не построен
+   */
+  std::vector<std::pair<int, int>> path(int from, int to) const;
+
+ private:
+  /**
+   * @brief Возвращает из двух ячеек ту, что ближе к корню
+   * @param[in] a номер первой ячейки
+   * @param[in] b номер второй ячейки
+   * @return Номер ячейки с меньшей глубиной
+   */
+  int shallower(int a, int b) const { return depth_[a] <= depth_[b] ? a : b; }
+
+  /**
+   * @brief Строит разреженную таблицу минимумов по блокам эйлерова обхода
+   */
+  void buildSparseTable();
+
+  /**
+   * @brief Очищает индекс
+   */
+  void clear();
+
+  /// количество столбцов лабиринта
+  int cols_;
+  /// родитель каждой ячейки в подвешенном дереве, -1 у корня
+  std::vector<int> parent_;
+  /// глубина каждой ячейки в подвешенном дереве
+  std::vector<int> depth_;
+  /// индекс первого вхождения ячейки в эйлеров обход
+  std::vector<int> first_;
+  /// эйлеров обход дерева
+  std::vector<int> euler_;
+  /// разреженная таблица: уровень k хранит минимумы 2^k подряд идущих блоков
+  std::vector<std::vector<int>> sparse_;
+};
+
+#endif  // MAZE_TREE_INDEX_H
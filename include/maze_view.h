@@ -1,21 +1,40 @@
 #ifndef MAZE_WIDGET_H
 #define MAZE_WIDGET_H
 
+#include <QCache>
 #include <QGraphicsItem>
 #include <QGraphicsView>
+#include <QImage>
 #include <QLabel>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QPainterPath>
+#include <QSet>
+#include <QThreadPool>
+#include <QWheelEvent>
 #include <QWidget>
+#include <utility>
 #include <vector>
 
+#include "maze_grid.h"
+
 /**
  * @class MazeView
  * @brief Класс для отрисовки лабиринта, его решения и интерактивного
  * взаимодействия с ним.
  *
  * Позволяет отдельно отрисовать сетку лабиринта, решения, с помощью мыши
- * указать точки старта и финиша для решения лабиринта.
+ * указать точки старта и финиша для решения лабиринта. Элементов сцены для
+ * ячеек нет: ячейка под курсором и положение ячейки на экране вычисляются из
+ * размера ячейки и отступов, поэтому отображение лабиринта любого размера
+ * не требует подготовки.
+ *
+ * Лабиринт можно приближать колесом мыши и перемещать правой или средней
+ * кнопкой. Стены рисуются плитками TILE_SIZE x TILE_SIZE пикселей, и только
+ * видимыми. Плитки отрисовываются в фоновых потоках для дискретных уровней
+ * масштаба и кэшируются. При сильном отдалении вместо линий рисуется обзор:
+ * яркость пикселя - доля стен в покрытом им блоке ячеек. Обзор всего
+ * лабиринта заменяет еще не готовые плитки и показывается как миникарта.
  *
  * @note Унаследован от QGraphicsView
  */
@@ -23,25 +42,8 @@ class MazeView : public QGraphicsView {
   Q_OBJECT
   using QGraphicsView::QGraphicsView;
 
-  /**
-   * @enum Wall
-   * @brief Определяет тип стены в ячейке лабиринта.
-   */
-  enum Wall {
-    RIGHT = 0b01,  ///< Стена справа
-    DOWN = 0b10    ///< Стена снизу
-  };
-
-  /**
-   * @enum Cell
-   * @brief Определяет данные, которые хранит элемент для отрисовки ячейки
-   * лабиринта.
-   */
-  enum Cell {
-    ROW = 0,     ///< Номер строки
-    COL = 1,     ///< Номер столбца
-    PRESSED = 2  ///< Флаг нажатия
-  };
+  /// Ячейка лабиринта: строка и столбец
+  using Cell = std::pair<int, int>;
 
   /**
    * @enum Color
@@ -60,6 +62,26 @@ class MazeView : public QGraphicsView {
   const QMap<Color, QColor> color_map = {{Color::WALL_COLOR, QColor(Qt::white)},
                                          {Color::PATH_COLOR, QColor(Qt::blue)}};
 
+  /// Размер стороны плитки в пикселях
+  constexpr static int TILE_SIZE = 256;
+  /// Количество уровней масштаба плиток на каждое удвоение размера ячейки
+  constexpr static int LEVELS_PER_OCTAVE = 4;
+  /// Наибольший размер ячейки при приближении в пикселях
+  constexpr static double MAX_CELL_SIZE = 64.0;
+  /// Наименьший размер ячейки в пикселях, при котором стены рисуются линиями
+  constexpr static double MIN_LINE_CELL_SIZE = 2.0;
+  /// Количество удвоений масштаба ниже MIN_LINE_CELL_SIZE, для которых
+  /// рисуются плитки обзора плотности; при большем отдалении они уменьшаются
+  constexpr static int DENSITY_OCTAVES = 16;
+  /// Наименьший размер иконок старта и финиша в пикселях
+  constexpr static double MIN_ICON_SIZE = 12.0;
+  /// Размер большей стороны обзора лабиринта (миникарты) в пикселях
+  constexpr static int OVERVIEW_SIZE = 160;
+  /// Отступ миникарты от края виджета в пикселях
+  constexpr static int OVERVIEW_MARGIN = 8;
+  /// Объем кэша плиток в килобайтах
+  constexpr static int TILE_CACHE_KB = 64 * 1024;
+
  public:
   /**
    * @brief Конструктор
@@ -68,23 +90,23 @@ class MazeView : public QGraphicsView {
   explicit MazeView(QWidget *parent = nullptr);
 
   /**
-   * @brief Деструктор
+   * @brief Деструктор. Дожидается фоновой отрисовки плиток.
    */
-  ~MazeView() = default;
+  ~MazeView();
 
   /**
-   * @brief Создает матрицу элементов (QGraphicsRectItem) для последующей
-   * отрисовки лабиринта, взаимодействия мышкой. Матрица подгоняется под размер
-   * виджета в зависимости от количества ячеек в лабирите. Каждый
-   * QGraphicsRectItem соответствует одной клетке лабиринта, хранит номер строки
-   * и столбца, информацию о клике по нему.
-   * @param[in] grid матрица со стенами лабиринта
+   * @brief Устанавливает отображаемый лабиринт и подгоняет размер ячеек под
+   * размер виджета. Время не зависит от количества ячеек.
+   * @param[in] grid представление стен лабиринта; стены не копируются, поэтому
+   * лабиринт должен жить, пока отображается. Перед изменением или удалением
+   * лабиринта нужно вызвать clearScene, чтобы остановить фоновую отрисовку.
    */
-  void setMaze(std::vector<std::vector<int>> grid);
+  void setMaze(MazeGridView grid);
 
   /**
-   * @brief Очищает сцену, матрицу QGraphicsRectItem, путь решения лабиринта и
-   * матрицу стен лабиринта
+   * @brief Очищает сцену, точки старта и финиша, путь решения лабиринта и
+   * представление стен лабиринта. Отменяет фоновую отрисовку плиток и
+   * дожидается уже начатой.
    */
   void clearScene();
 
@@ -95,8 +117,8 @@ class MazeView : public QGraphicsView {
   void sendSelectedPoints();
 
   /**
-   * @brief Отрисовывает путь решения лабиринта с помощью отдельных
-   * элементов-линий (QGraphicsLineItem)
+   * @brief Отрисовывает путь решения лабиринта одной ломаной
+   * (QGraphicsPathItem): шаги в одном направлении сливаются в один отрезок
    * @param[in] path путь решения лабиринта
    */
   void paintMazeSolution(std::vector<std::pair<int, int>> path);
@@ -120,13 +142,32 @@ class MazeView : public QGraphicsView {
 
  protected:
   /**
-   * @brief Обрабатывает событие нажатия мыши на виджете лабиринта, определяет
-   * выбранную ячейку лабиринта при клике и устанавливает точки старта или
-   * финиша в зависимости от текущего состояния
+   * @brief Обрабатывает событие нажатия мыши на виджете лабиринта. Левая
+   * кнопка выбирает ячейку и устанавливает точки старта или финиша в
+   * зависимости от текущего состояния, правая и средняя начинают
+   * перемещение лабиринта.
    * @param[in] event указатель на событие мыши
    */
   void mousePressEvent(QMouseEvent *event) override;
 
+  /**
+   * @brief Перемещает лабиринт вслед за мышью
+   * @param[in] event указатель на событие мыши
+   */
+  void mouseMoveEvent(QMouseEvent *event) override;
+
+  /**
+   * @brief Завершает перемещение лабиринта
+   * @param[in] event указатель на событие мыши
+   */
+  void mouseReleaseEvent(QMouseEvent *event) override;
+
+  /**
+   * @brief Приближает или отдаляет лабиринт относительно точки под курсором
+   * @param[in] event указатель на событие колеса мыши
+   */
+  void wheelEvent(QWheelEvent *event) override;
+
   /**
    * @brief Переопределяет событие перерисовки виджета лабиринта
    * @param[in] event указатель на событие перерисовки
@@ -134,17 +175,65 @@ class MazeView : public QGraphicsView {
   void paintEvent(QPaintEvent *event) override;
 
   /**
-   * @brief Находит элемент (QGraphicsRectItem) сцены виджета отрисовки по
-   * указанным координатам строки и столбца
-   * @param[in] row строка ячейки в лабиринте
-   * @param[in] col столбец ячейки в лабиринте
-   * @return Указатель на QGraphicsRectItem или nullptr,
-   * если ячейка не найдена
+   * @brief Пересчитывает размер ячеек и отступы под новый размер виджета
+   * @param[in] event указатель на событие изменения размера
+   */
+  void resizeEvent(QResizeEvent *event) override;
+
+  /**
+   * @brief Вычисляет размер ячейки, при котором лабиринт целиком помещается
+   * в виджет
+   * @return Размер ячейки в пикселях
+   */
+  double fitCellSize() const;
+
+  /**
+   * @brief Показывает лабиринт целиком по центру виджета
+   */
+  void fitToView();
+
+  /**
+   * @brief Ограничивает отступы так, чтобы лабиринт не уходил за края
+   * виджета, а меньший виджета лабиринт оставался по центру
+   */
+  void clampOffsets();
+
+  /**
+   * @brief Применяет новые размер ячейки и отступы: перестраивает решение,
+   * иконки и перерисовывает виджет
    */
-  QGraphicsRectItem *findCell(int row, int col);
+  void updateView();
 
   /**
-   * @brief Очищает решение лабиринта - удаляет все линии для его изображения
+   * @brief Масштабирует иконки точек старта и финиша под размер ячейки
+   */
+  void scaleIcons();
+
+  /**
+   * @brief Вычисляет прямоугольник ячейки в координатах виджета
+   * @param[in] cell ячейка лабиринта
+   * @return Прямоугольник ячейки
+   */
+  QRectF cellRect(Cell cell) const;
+
+  /**
+   * @brief Определяет ячейку лабиринта по координатам виджета
+   * @param[in] pos координаты точки
+   * @param[out] cell ячейка под точкой
+   * @return true, если точка попадает в лабиринт
+   */
+  bool cellAt(QPointF pos, Cell &cell) const;
+
+  /**
+   * @brief Строит ломаную пути решения через центры ячеек в координатах
+   * ячеек. Вершины ставятся только в точках поворота, поэтому прямой
+   * коридор - один отрезок.
+   * @return Ломаная пути решения
+   */
+  QPainterPath solutionPath() const;
+
+  /**
+   * @brief Очищает решение лабиринта - удаляет ломаную для его изображения
    */
   void clearMazeSolution();
 
@@ -152,27 +241,110 @@ class MazeView : public QGraphicsView {
    * @brief Добавляет ячейку с указанным ключом в словарь для хранения
    * точек старта и финиша решения лабиринта
    * @param[in] type тип ячейки и её ключ в словаре
-   * @param[in] rect ячейка (QGraphicsRectItem)
+   * @param[in] cell ячейка лабиринта
    */
-  void setPoint(QString type, QGraphicsRectItem *rect);
+  void setPoint(QString type, Cell cell);
 
   /**
    * @brief Удаляет ячейку с указанным ключом из словаря для хранения
    * точек старта и финиша решения лабиринта
    * @param[in] type тип ячейки и её ключ в словаре
-   * @param[in] rect ячейка (QGraphicsRectItem)
    */
-  void removePoint(QString type, QGraphicsRectItem *rect);
+  void removePoint(QString type);
+
+  /**
+   * @brief Рисует видимые плитки стен. Недостающие плитки заказываются в
+   * фоне, а на их месте рисуется соответствующая часть обзора.
+   * @param[in] painter рисовальщик виджета
+   */
+  void paintTiles(QPainter &painter);
+
+  /**
+   * @brief Рисует миникарту с рамкой видимой области
+   * @param[in] painter рисовальщик виджета
+   */
+  void paintOverview(QPainter &painter);
+
+  /**
+   * @brief Заказывает фоновую отрисовку плитки
+   * @param[in] level уровень масштаба
+   * @param[in] tile_x номер плитки по горизонтали
+   * @param[in] tile_y номер плитки по вертикали
+   */
+  void requestTile(int level, int tile_x, int tile_y);
+
+  /**
+   * @brief Заказывает фоновую отрисовку обзора всего лабиринта
+   */
+  void requestOverview();
+
+  /**
+   * @brief Вычисляет уровень масштаба плиток - ближайший не меньший размера
+   * ячейки
+   * @param[in] cell_size размер ячейки в пикселях, больше нуля
+   * @return Уровень масштаба
+   */
+  static int levelFor(double cell_size);
+
+  /**
+   * @brief Возвращает размер ячейки на уровне масштаба плиток
+   * @param[in] level уровень масштаба
+   * @return Размер ячейки в пикселях
+   */
+  static double levelScale(int level);
+
+  /**
+   * @brief Составляет ключ плитки в кэше
+   * @param[in] level уровень масштаба
+   * @param[in] tile_x номер плитки по горизонтали
+   * @param[in] tile_y номер плитки по вертикали
+   * @return Ключ плитки
+   */
+  static quint64 tileKey(int level, int tile_x, int tile_y);
 
  private:
   /// Указатель на графическую сцену для отрисовки элементов лабиринта
   QGraphicsScene *scene_;
   /// Словарь для хранения точек старта и финиша решения лабиринта
-  QMap<QString, QGraphicsRectItem *> selected_points_;
+  QMap<QString, Cell> selected_points_;
   /// Размер ячейки лабиринта
   double cell_size_;
-  /// Матрица со стенами лабиринта
-  std::vector<std::vector<int>> maze_grid_;
+  /// Отступ лабиринта от левого края виджета
+  double offset_x_;
+  /// Отступ лабиринта от верхнего края виджета
+  double offset_y_;
+  /// Лабиринт показан целиком и подгоняется под размер виджета
+  bool fitted_;
+  /// Идет перемещение лабиринта мышью
+  bool panning_;
+  /// Последняя позиция мыши при перемещении
+  QPointF pan_pos_;
+  /// Путь решения лабиринта, перерисовывается при изменении размера
+  std::vector<Cell> solution_;
+  /// Элемент сцены с ломаной решения, nullptr - решения нет
+  QGraphicsPathItem *solution_item_;
+  /// Исходные иконки точек старта и финиша, загружаются один раз
+  QMap<QString, QPixmap> icon_sources_;
+  /// Иконки точек старта и финиша, масштабированные под размер ячейки
+  QMap<QString, QPixmap> icons_;
+  /// Представление стен отображаемого лабиринта
+  MazeGridView maze_grid_;
+  /// Потоки фоновой отрисовки плиток
+  QThreadPool pool_;
+  /// Готовые плитки, стоимость - размер в килобайтах
+  QCache<quint64, QPixmap> tiles_;
+  /// Плитки, заказанные, но еще не готовые
+  QSet<quint64> pending_;
+  /// Уровень масштаба видимых плиток
+  int level_;
+  /// Номер лабиринта: результаты фоновой отрисовки прежнего отбрасываются
+  int generation_;
+  /// Обзор всего лабиринта
+  QPixmap overview_;
+  /// Размер ячейки в обзоре в пикселях
+  double overview_scale_;
+  /// Обзор заказан, но еще не готов
+  bool overview_pending_;
 };
 
-#endif  // MAZE_WIDGET_H
\ No newline at end of file
+#endif  // MAZE_WIDGET_H
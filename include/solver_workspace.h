@@ -0,0 +1,290 @@
+#ifndef SOLVER_WORKSPACE_H
+#define SOLVER_WORKSPACE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct OpenEntry
+ * @brief Элемент открытого списка алгоритма A*
+ */
+struct OpenEntry {
+  int f;   ///< Оценка длины пути через ячейку: g + эвристика
+  int g;   ///< Длина пути от старта до ячейки на момент добавления
+  int id;  ///< Номер ячейки
+};
+
+/**
+ * @class HeapQueue
+ * @brief Очередь с приоритетом для A* на двоичной куче. Первой извлекается
+ * ячейка с наименьшей оценкой f, при равенстве - с наибольшей длиной g.
+ */
+class HeapQueue {
+ public:
+  /// Очищает очередь, сохраняя выделенную память
+  void clear() { heap_.clear(); }
+
+  /// Проверяет, пуста ли очередь
+  bool empty() const { return heap_.empty(); }
+
+  /// Добавляет элемент в очередь
+  void push(OpenEntry entry) {
+    heap_.push_back(entry);
+    std::push_heap(heap_.begin(), heap_.end(), less);
+  }
+
+  /// Извлекает элемент с наивысшим приоритетом
+  OpenEntry pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), less);
+    OpenEntry entry = heap_.back();
+    heap_.pop_back();
+    return entry;
+  }
+
+ private:
+  /// Сравнение для кучи: true, если приоритет a ниже приоритета b
+  static bool less(const OpenEntry &a, const OpenEntry &b) {
+    return a.f > b.f || (a.f == b.f && a.g < b.g);
+  }
+
+  /// элементы кучи
+  std::vector<OpenEntry> heap_;
+};
+
+/**
+ * @class BucketQueue
+ * @brief Очередь с приоритетом для A* на корзинах по значению f.
+ *
+ * При единичной стоимости шагов и манхэттенской эвристике оценка f соседа
+ * равна f раскрываемой ячейки или больше её на 2, поэтому все элементы
+ * очереди лежат в диапазоне [f_min, f_min + 2] и хватает кольца из четырех
+ * корзин. Добавление и извлечение выполняются за O(1). Внутри корзины ячейки
+ * извлекаются в обратном порядке, что отдает приоритет более глубоким.
+ */
+class BucketQueue {
+ public:
+  /// Очищает очередь, сохраняя выделенную память
+  void clear() {
+    for (std::vector<OpenEntry> &bucket : buckets_) bucket.clear();
+    size_ = 0;
+  }
+
+  /// Проверяет, пуста ли очередь
+  bool empty() const { return size_ == 0; }
+
+  /// Добавляет элемент в очередь
+  void push(OpenEntry entry) {
+    if (size_ == 0 || entry.f < current_) current_ = entry.f;
+    buckets_[entry.f & 3].push_back(entry);
+    size_++;
+  }
+
+  /// Извлекает элемент с наименьшей оценкой f
+  OpenEntry pop() {
+    while (buckets_[current_ & 3].empty()) current_++;
+    std::vector<OpenEntry> &bucket = buckets_[current_ & 3];
+    OpenEntry entry = bucket.back();
+    bucket.pop_back();
+    size_--;
+    return entry;
+  }
+
+ private:
+  /// кольцо корзин, корзина выбирается по двум младшим битам f
+  std::vector<OpenEntry> buckets_[4];
+  /// наименьшая оценка f среди элементов очереди
+  int current_ = 0;
+  /// количество элементов в очереди
+  int size_ = 0;
+};
+
+/**
+ * @class SolverWorkspace
+ * @brief Рабочая память для поиска пути в лабиринте: массив родителей,
+ * отметки посещения и очередь фиксированной емкости.
+ *
+ * Буферы выделяются один раз под количество ячеек лабиринта и переиспользуются
+ * между поисками. Отметка посещения ячейки хранит номер поколения, поэтому
+ * сброс перед новым поиском - это увеличение счетчика поколений за O(1), без
+ * очистки массивов. Для двунаправленного поиска ведутся два фронта с
+ * отдельными очередями, фронт ячейки хранится в младшем бите отметки.
+ */
+class SolverWorkspace {
+ public:
+  /**
+   * @brief Конструктор по умолчанию
+   */
+  SolverWorkspace();
+
+  /**
+   * @brief Конструктор. Сразу выделяет память под указанное число ячеек.
+   * @param[in] cells количество ячеек лабиринта
+   */
+  explicit SolverWorkspace(int cells);
+
+  /**
+   * @brief Деструктор
+   */
+  ~SolverWorkspace() = default;
+
+  /**
+   * @brief Подготавливает рабочую память к новому поиску: при необходимости
+   * увеличивает буферы, сбрасывает отметки посещения и очищает очереди
+   * @param[in] cells количество ячеек лабиринта
+   * @param[in] sides количество очередей обхода в ширину (1 - обычный обход,
+   * 2 - двунаправленный, 0 - очереди не нужны)
+   * @param[in] distances true, если поиску нужны длины путей до ячеек (A*)
+   */
+  void reset(int cells, int sides = 1, bool distances = false);
+
+  /**
+   * @brief Возвращает количество ячеек, под которое выделена память
+   * @return Емкость рабочей памяти
+   */
+  int capacity() const { return static_cast<int>(parent_.size()); }
+
+  /**
+   * @brief Проверяет, была ли ячейка посещена в текущем поиске
+   * @param[in] id номер ячейки
+   * @return true, если ячейка посещена
+   */
+  bool isVisited(int id) const { return (marks_[id] >> 1) == generation_; }
+
+  /**
+   * @brief Возвращает фронт, которым была посещена ячейка
+   * @param[in] id номер посещенной ячейки
+   * @return Номер фронта
+   */
+  int side(int id) const { return marks_[id] & 1; }
+
+  /**
+   * @brief Отмечает ячейку посещенной и запоминает её родителя
+   * @param[in] id номер ячейки
+   * @param[in] parent номер ячейки-родителя или -1 для начальной точки
+   * @param[in] side номер фронта поиска
+   */
+  void visit(int id, int parent, int side = 0) {
+    marks_[id] = (generation_ << 1) | side;
+    parent_[id] = parent;
+  }
+
+  /**
+   * @brief Возвращает родителя посещенной ячейки
+   * @param[in] id номер ячейки
+   * @return Номер ячейки-родителя или -1 для начальной точки
+   */
+  int parent(int id) const { return parent_[id]; }
+
+  /**
+   * @brief Запоминает длину пути от старта до посещенной ячейки
+   * @param[in] id номер ячейки
+   * @param[in] distance длина пути
+   */
+  void setDistance(int id, int distance) { distance_[id] = distance; }
+
+  /**
+   * @brief Возвращает длину пути от старта до посещенной ячейки
+   * @param[in] id номер ячейки
+   * @return Длина пути
+   */
+  int distance(int id) const { return distance_[id]; }
+
+  /**
+   * @brief Увеличивает счетчик раскрытых ячеек текущего поиска
+   */
+  void markExpanded() { expanded_++; }
+
+  /**
+   * @brief Возвращает количество ячеек, раскрытых последним поиском. Позволяет
+   * сравнивать объем работы разных алгоритмов.
+   * @return Количество раскрытых ячеек
+   */
+  int expanded() const { return expanded_; }
+
+  /**
+   * @brief Возвращает очередь A* на двоичной куче
+   * @return Ссылка на очередь
+   */
+  HeapQueue &heapQueue() { return heap_queue_; }
+
+  /**
+   * @brief Возвращает очередь A* на корзинах
+   * @return Ссылка на очередь
+   */
+  BucketQueue &bucketQueue() { return bucket_queue_; }
+
+  /**
+   * @brief Добавляет ячейку в конец очереди фронта
+   * @param[in] id номер ячейки
+   * @param[in] side номер фронта поиска
+   */
+  void push(int id, int side = 0) { queues_[side].push(id); }
+
+  /**
+   * @brief Извлекает ячейку из начала очереди фронта
+   * @param[in] side номер фронта поиска
+   * @return Номер ячейки
+   */
+  int pop(int side = 0) { return queues_[side].pop(); }
+
+  /**
+   * @brief Проверяет, пуста ли очередь фронта
+   * @param[in] side номер фронта поиска
+   * @return true, если очередь пуста
+   */
+  bool queueEmpty(int side = 0) const { return queues_[side].size == 0; }
+
+  /**
+   * @brief Возвращает количество ячеек в очереди фронта
+   * @param[in] side номер фронта поиска
+   * @return Размер очереди
+   */
+  int queueSize(int side = 0) const { return queues_[side].size; }
+
+ private:
+  /**
+   * @struct RingQueue
+   * @brief Очередь фиксированной емкости на кольцевом буфере
+   */
+  struct RingQueue {
+    std::vector<int> buffer;  ///< Кольцевой буфер
+    int head = 0;             ///< Индекс начала очереди
+    int tail = 0;             ///< Индекс конца очереди
+    int size = 0;             ///< Количество элементов
+
+    /// Добавляет элемент в конец очереди
+    void push(int id) {
+      buffer[tail] = id;
+      if (++tail == static_cast<int>(buffer.size())) tail = 0;
+      size++;
+    }
+
+    /// Извлекает элемент из начала очереди
+    int pop() {
+      int id = buffer[head];
+      if (++head == static_cast<int>(buffer.size())) head = 0;
+      size--;
+      return id;
+    }
+  };
+
+  /// номер текущего поколения отметок посещения
+  std::uint32_t generation_;
+  /// отметки посещения: номер поколения, сдвинутый на бит, и номер фронта
+  std::vector<std::uint32_t> marks_;
+  /// родители посещенных ячеек
+  std::vector<int> parent_;
+  /// очереди обхода прямого и обратного фронтов
+  RingQueue queues_[2];
+  /// длины путей от старта до посещенных ячеек
+  std::vector<int> distance_;
+  /// количество ячеек, раскрытых последним поиском
+  int expanded_;
+  /// очередь A* на двоичной куче
+  HeapQueue heap_queue_;
+  /// очередь A* на корзинах
+  BucketQueue bucket_queue_;
+};
+
+#endif  // SOLVER_WORKSPACE_H
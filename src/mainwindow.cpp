@@ -1,20 +1,32 @@
 #include "../include/mainwindow.h"
 
+#include <cstring>
+
 #include "../resources/ui_mainwindow.h"
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow),
-      maze_(Maze(0, 0)),
-      bldr_(MazeBuilder()) {
+      maze_(std::make_shared<Maze>(0, 0)),
+      bldr_(MazeBuilder()),
+      task_id_(0) {
   ui->setupUi(this);
 
+  // типы результатов передаются между потоками в очереди сигналов
+  qRegisterMetaType<std::shared_ptr<Maze>>();
+  qRegisterMetaType<MazeDescriptor>();
+  qRegisterMetaType<MazePath>();
+
   // пока лабиринт не создан/загружен, кнопки сохранения и решения не доступны
   ui->save_btn->setEnabled(false);
   ui->solve_maze_btn->setEnabled(false);
   ui->rows_create_spb->setValue(DEFAULT_ROWS);
   ui->cols_create_spb->setValue(DEFAULT_COLS);
 
+  // фоновые задачи выполняются по одной в порядке запуска
+  pool_.setMaxThreadCount(1);
+  task_timer_.setSingleShot(true);
+
   // настройка соединений кнопок
   connect(ui->generate_maze_btn, &QPushButton::pressed, this,
           &MainWindow::generateMaze);
@@ -26,40 +38,61 @@ MainWindow::MainWindow(QWidget *parent)
           &MainWindow::updateFinishPoint);
   connect(ui->solve_maze_btn, &QPushButton::pressed, this,
           &MainWindow::showMazeSolution);
+  connect(ui->cancel_btn, &QPushButton::pressed, this,
+          &MainWindow::cancelTask);
+  connect(&task_timer_, &QTimer::timeout, this,
+          &MainWindow::stopOverdueTask);
+
+  // сигналы фоновых задач испускаются в потоке задач, слоты - в потоке окна
+  connect(this, &MainWindow::taskProgress, this,
+          &MainWindow::updateTaskProgress, Qt::QueuedConnection);
+  connect(this, &MainWindow::mazeGenerated, this,
+          &MainWindow::setGeneratedMaze, Qt::QueuedConnection);
+  connect(this, &MainWindow::mazeLoaded, this, &MainWindow::setLoadedMaze,
+          Qt::QueuedConnection);
+  connect(this, &MainWindow::solutionFound, this,
+          &MainWindow::setMazeSolution, Qt::QueuedConnection);
+  connect(this, &MainWindow::taskFinished, this, &MainWindow::releaseWorker,
+          Qt::QueuedConnection);
+  connect(this, &MainWindow::taskFailed, this,
+          &MainWindow::reportTaskFailure, Qt::QueuedConnection);
 }
 
-MainWindow::~MainWindow() { delete ui; }
+MainWindow::~MainWindow() {
+  // задача обращается к строителю и испускает сигналы окна, поэтому окно
+  // отменяет ее и дожидается завершения
+  task_id_++;
+  pool_.clear();
+  pool_.waitForDone();
+  delete ui;
+}
 
 void MainWindow::generateMaze() {
   int rows = ui->rows_create_spb->value();
   int cols = ui->cols_create_spb->value();
-  maze_ = bldr_.createMaze(rows, cols);
-  ui->maze_view->setMaze(maze_.grid());
-  ui->save_btn->setEnabled(true);
-  ui->solve_maze_btn->setEnabled(true);
-  ui->file_name_lbl->clear();
-  ui->loaded_maze_size_lbl->clear();
+  int task = startTask("Generating", true);
+  runTask(task, "Generation failed", [this, task, rows, cols]() {
+    MazeGrid grid(rows, cols);
+    // строки копируются по мере готовности, отмена проверяется после каждой
+    bool complete = bldr_.generate(rows, cols, collectRows(task, grid));
+    if (isCancelled(task)) return;
+    std::shared_ptr<Maze> maze;
+    if (complete) maze = std::make_shared<Maze>(std::move(grid));
+    emit mazeGenerated(task, maze,
+                       bldr_.describe(rows, cols, bldr_.lastSeed()));
+  });
 }
 
 void MainWindow::loadFromFile() {
   QString file_path = QFileDialog::getOpenFileName(this, "Open file", "");
   if (!file_path.isEmpty()) {
-    maze_ = MazeSerializer::readFromFile(file_path.toStdString());
-    QFileInfo file_info(file_path);
-    ui->file_name_lbl->setText(file_info.fileName());
-    if (!maze_.isEmpty()) {
-      ui->maze_view->setMaze(maze_.grid());
-      ui->save_btn->setEnabled(true);
-      ui->solve_maze_btn->setEnabled(true);
-      QString size = QString::number(maze_.getRows()) + "x" +
-                     QString::number(maze_.getCols());
-      ui->loaded_maze_size_lbl->setText(size);
-    } else {
-      ui->maze_view->clearScene();
-      ui->save_btn->setEnabled(false);
-      ui->solve_maze_btn->setEnabled(false);
-      ui->loaded_maze_size_lbl->clear();
-    }
+    int task = startTask("Loading", false);
+    std::string path = file_path.toStdString();
+    QString file_name = QFileInfo(file_path).fileName();
+    runTask(task, "Load failed", [this, task, path, file_name]() {
+      std::shared_ptr<Maze> maze = readMaze(task, path);
+      if (!isCancelled(task)) emit mazeLoaded(task, maze, file_name);
+    });
   }
 }
 
@@ -67,11 +100,22 @@ void MainWindow::saveToFile() {
   QString file_name =
       "Maze_" + QDateTime::currentDateTime().toString("yyyy-MM-dd_hhmmss") +
       ".txt";
-  QString file_type("Text (*.txt)");
+  QString file_type("Text (*.txt);;Binary (*.maze);;Compressed (*.mazez)");
+  // сгенерированный лабиринт можно сохранить описанием из нескольких байт
+  if (descriptor_) file_type += ";;Descriptor (*.mazegen)";
   QString file_path =
       QFileDialog::getSaveFileName(this, "Save maze", file_name, file_type);
-  if (!file_path.isEmpty())
-    MazeSerializer::saveToFile(maze_, file_path.toStdString());
+  if (file_path.isEmpty()) return;
+  // формат файла выбирается по расширению
+  if (descriptor_ && file_path.endsWith(".mazegen"))
+    MazeSerializer::saveDescriptor(*descriptor_, file_path.toStdString());
+  else if (file_path.endsWith(".mazez"))
+    MazeSerializer::saveToCompressedFile(maze_->grid(),
+                                         file_path.toStdString());
+  else if (file_path.endsWith(".maze"))
+    MazeSerializer::saveToBinaryFile(maze_->grid(), file_path.toStdString());
+  else
+    MazeSerializer::saveToFile(maze_->grid(), file_path.toStdString());
 }
 
 void MainWindow::updateStartPoint(int x, int y) {
@@ -85,8 +129,8 @@ void MainWindow::updateFinishPoint(int x, int y) {
 }
 
 void MainWindow::showMazeSolution() {
-  int max_row = maze_.getRows() - 1;
-  int max_col = maze_.getCols() - 1;
+  int max_row = maze_->getRows() - 1;
+  int max_col = maze_->getCols() - 1;
 
   // проверка заданных точек старта и финиша решения лабиринта. при выходе за
   // границы будут установлены максимальные корректные для текущего
@@ -96,10 +140,6 @@ void MainWindow::showMazeSolution() {
   int row_finish = qBound(0, ui->finish_row_spb->value(), max_row);
   int col_finish = qBound(0, ui->finish_col_spb->value(), max_col);
 
-  // получаем путь (решение лабиринта) и передаем в виджет отрисовки
-  auto path = maze_.getSolution(row_start, col_start, row_finish, col_finish);
-  ui->maze_view->paintMazeSolution(path);
-
   // обновляем значения в спинбоксах в соответствии с решением
   if (row_start != ui->start_row_spb->value())
     ui->start_row_spb->setValue(row_start);
@@ -110,4 +150,175 @@ void MainWindow::showMazeSolution() {
     ui->finish_row_spb->setValue(row_finish);
   if (col_finish != ui->finish_col_spb->value())
     ui->finish_col_spb->setValue(col_finish);
-}
\ No newline at end of file
+
+  // путь ищется в фоне; задача держит ссылку на лабиринт, поэтому он
+  // доживет до ее конца, даже если задачу отменят и лабиринт заменят
+  int task = startTask("Solving", false);
+  std::shared_ptr<Maze> maze = maze_;
+  runTask(task, "Solving failed",
+          [this, task, maze, row_start, col_start, row_finish, col_finish]() {
+            MazePath path = maze->getSolution(row_start, col_start,
+                                              row_finish, col_finish);
+            if (!isCancelled(task)) emit solutionFound(task, path);
+          });
+}
+
+void MainWindow::cancelTask() { stopTask("Cancelled"); }
+
+void MainWindow::stopOverdueTask() { stopTask("Time limit exceeded"); }
+
+void MainWindow::releaseWorker() { finishTask(task_message_); }
+
+void MainWindow::reportTaskFailure(int task, QString message) {
+  if (task == task_id_) task_message_ = message;
+}
+
+void MainWindow::updateTaskProgress(int task, int percent) {
+  if (task != task_id_) return;
+  // загрузка узнает, что файл читается по строкам, только начав его читать
+  if (ui->task_pbar->maximum() == 0) {
+    ui->task_pbar->setRange(0, 100);
+    ui->task_pbar->setFormat(ui->task_pbar->format() + " %p%");
+  }
+  ui->task_pbar->setValue(percent);
+}
+
+void MainWindow::setGeneratedMaze(int task, std::shared_ptr<Maze> maze,
+                                  MazeDescriptor descriptor) {
+  if (task != task_id_) return;
+  if (!maze) {
+    task_message_ = "Generation failed";
+    return;
+  }
+  // отображение читает стены лабиринта, поэтому очищается до его замены
+  ui->maze_view->clearScene();
+  maze_ = maze;
+  descriptor_ = descriptor;
+  ui->maze_view->setMaze(maze_->grid());
+  ui->file_name_lbl->clear();
+  ui->loaded_maze_size_lbl->clear();
+}
+
+void MainWindow::setLoadedMaze(int task, std::shared_ptr<Maze> maze,
+                               QString file_name) {
+  if (task != task_id_) return;
+  ui->maze_view->clearScene();
+  maze_ = maze;
+  descriptor_.reset();
+  ui->file_name_lbl->setText(file_name);
+  if (!maze_->isEmpty()) {
+    ui->maze_view->setMaze(maze_->grid());
+    QString size = QString::number(maze_->getRows()) + "x" +
+                   QString::number(maze_->getCols());
+    ui->loaded_maze_size_lbl->setText(size);
+  } else {
+    ui->loaded_maze_size_lbl->clear();
+    task_message_ = "Load failed";
+  }
+}
+
+void MainWindow::setMazeSolution(int task, MazePath path) {
+  if (task != task_id_) return;
+  ui->maze_view->paintMazeSolution(path);
+}
+
+void MainWindow::runTask(int task, const QString &failure,
+                         std::function<void()> work) {
+  // задачи выполняются по одной, поэтому сигнал завершения освобождает
+  // кнопки только после того, как поток действительно свободен. исключение
+  // не должно покинуть поток пула - это завершило бы приложение
+  pool_.start([this, task, failure, work]() {
+    try {
+      work();
+    } catch (...) {
+      if (!isCancelled(task)) emit taskFailed(task, failure);
+    }
+    emit taskFinished();
+  });
+}
+
+MazeRowSink MainWindow::collectRows(int task, MazeGrid &grid) {
+  auto reported = std::make_shared<int>(0);
+  return [this, task, &grid, reported](int row, MazeGridView line) {
+    grid.copyRow(line, 0, row);
+    int percent = static_cast<int>((row + 1) * 100LL / grid.rows());
+    if (percent != *reported) {
+      *reported = percent;
+      emit taskProgress(task, percent);
+    }
+    return !isCancelled(task);
+  };
+}
+
+std::shared_ptr<Maze> MainWindow::readMaze(int task, const std::string &path) {
+  char magic[sizeof(MazeSerializer::BINARY_MAGIC)] = {};
+  std::ifstream(path, std::ios::binary).read(magic, sizeof(magic));
+  MazeFileHeader header;
+  MazeDescriptor descriptor;
+  bool compressed = std::memcmp(magic, MazeSerializer::COMPRESSED_MAGIC,
+                                sizeof(magic)) == 0 &&
+                    MazeSerializer::readBinaryHeader(path, header);
+  bool described = std::memcmp(magic, MazeSerializer::DESCRIPTOR_MAGIC,
+                               sizeof(magic)) == 0 &&
+                   MazeSerializer::readDescriptor(path, descriptor);
+  if (!compressed && !described)
+    return std::make_shared<Maze>(MazeSerializer::readFromFile(path));
+
+  MazeGrid grid(compressed ? header.rows : descriptor.rows,
+                compressed ? header.cols : descriptor.cols);
+  bool complete =
+      compressed ? MazeSerializer::readCompressedRows(
+                       path, 0, grid.rows(), collectRows(task, grid))
+                 : MazeSerializer::readDescriptorRows(
+                       path, 0, grid.rows(), collectRows(task, grid));
+  // как и readFromFile, сжатый файл проверяется контрольной суммой
+  if (!complete ||
+      (compressed && MazeSerializer::checksum(grid) != header.checksum))
+    return std::make_shared<Maze>(0, 0);
+  return std::make_shared<Maze>(std::move(grid));
+}
+
+void MainWindow::stopTask(const QString &message) {
+  // задача увидит новый номер и прервется или выбросит результат; кнопки
+  // задач остаются недоступны, пока она не вернет поток
+  task_id_++;
+  task_timer_.stop();
+  task_message_ = message;
+  ui->cancel_btn->setEnabled(false);
+  ui->task_pbar->setRange(0, 0);
+  ui->task_pbar->setFormat("Stopping");
+}
+
+int MainWindow::startTask(const QString &title, bool determinate) {
+  // пока задача выполняется, новые задачи и сохранение недоступны
+  ui->generate_maze_btn->setEnabled(false);
+  ui->load_btn->setEnabled(false);
+  ui->save_btn->setEnabled(false);
+  ui->solve_maze_btn->setEnabled(false);
+  ui->cancel_btn->setEnabled(true);
+
+  // без процентов индикатор с нулевым диапазоном показывает занятость
+  ui->task_pbar->setEnabled(true);
+  ui->task_pbar->setRange(0, determinate ? 100 : 0);
+  ui->task_pbar->setValue(0);
+  ui->task_pbar->setFormat(determinate ? title + " %p%" : title);
+
+  task_message_.clear();
+  task_timer_.start(TASK_TIME_BUDGET_MS);
+  return ++task_id_;
+}
+
+void MainWindow::finishTask(const QString &message) {
+  task_timer_.stop();
+
+  ui->generate_maze_btn->setEnabled(true);
+  ui->load_btn->setEnabled(true);
+  ui->save_btn->setEnabled(!maze_->isEmpty());
+  ui->solve_maze_btn->setEnabled(!maze_->isEmpty());
+  ui->cancel_btn->setEnabled(false);
+
+  ui->task_pbar->setRange(0, 100);
+  ui->task_pbar->setValue(0);
+  ui->task_pbar->setFormat(message);
+  ui->task_pbar->setEnabled(false);
+}
@@ -1,19 +1,36 @@
 #include "../include/maze.h"
 
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
 Maze::Maze(int rows, int cols)
-    : rows_(rows),
-      cols_(cols),
-      grid_(std::vector<std::vector<int>>(rows, std::vector<int>(cols, 0))),
-      vertices_(std::vector<std::vector<Vertex>>(
-          rows, std::vector<Vertex>(cols_, {0, 0, 0}))) {
-  indexVertices();
-};
+    : rows_(rows), cols_(cols), grid_(MazeGrid(rows, cols)) {};
+
+Maze::Maze(MazeGrid grid)
+    : rows_(grid.rows()), cols_(grid.cols()), grid_(std::move(grid)) {}
+
+Maze::Maze(Maze &&other) noexcept
+    : rows_(std::exchange(other.rows_, 0)),
+      cols_(std::exchange(other.cols_, 0)),
+      grid_(std::move(other.grid_)),
+      tree_index_(std::move(other.tree_index_)) {}
+
+Maze &Maze::operator=(Maze &&other) noexcept {
+  if (this == &other) return *this;
+  // размеры обнуляются вместе со стенами, чтобы исходный лабиринт был пустым
+  rows_ = std::exchange(other.rows_, 0);
+  cols_ = std::exchange(other.cols_, 0);
+  grid_ = std::move(other.grid_);
+  tree_index_ = std::move(other.tree_index_);
+  return *this;
+}
 
-int Maze::getCols() { return cols_; }
+int Maze::getCols() const { return cols_; }
 
-int Maze::getRows() { return rows_; }
+int Maze::getRows() const { return rows_; }
 
-std::vector<std::vector<int>> Maze::grid() { return grid_; }
+MazeGridView Maze::grid() const { return grid_.view(); }
 
 // void Maze::print() {
 //   std::cout << " ";
@@ -25,115 +42,284 @@ std::vector<std::vector<int>> Maze::grid() { return grid_; }
 //   for (int i = 0; i < rows_; i++) {
 //     std::cout << "|";
 //     for (int j = 0; j < cols_; j++) {
-//       if (grid_[i][j] == Wall::BOTH) std::cout << "_|";
-//       if (grid_[i][j] == Wall::DOWN) std::cout << "__";
-//       if (grid_[i][j] == Wall::RIGHT) std::cout << " |";
-//       if (grid_[i][j] == Wall::NONE) std::cout << "  ";
+//       if (grid_.at(i, j) == Wall::BOTH) std::cout << "_|";
+//       if (grid_.at(i, j) == Wall::DOWN) std::cout << "__";
+//       if (grid_.at(i, j) == Wall::RIGHT) std::cout << " |";
+//       if (grid_.at(i, j) == Wall::NONE) std::cout << "  ";
 //       if (j == cols_ - 1) std::cout << "\n";
 //     }
 //   }
 // }
 
-void Maze::generateGraph() {
-  graph_ = std::vector<std::vector<int>>(rows_ * cols_);
+std::vector<std::pair<int, int>> Maze::getSolution(int row1, int col1, int row2,
+                                                   int col2,
+                                                   SolveMethod method) const {
+  // у каждого потока своя рабочая память, переиспользуемая между вызовами
+  thread_local SolverWorkspace workspace;
+  return getSolution(row1, col1, row2, col2, workspace, method);
+}
 
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      if (j != 0) {
-        // если у ячейки слева от текущей нет правой стены
-        if ((grid_[i][j - 1] & Wall::RIGHT) != Wall::RIGHT)
-          // добавляем её как соседа для текущей ячейки
-          graph_[vertices_[i][j].id].push_back(vertices_[i][j - 1].id);
-      }
-      if (j != cols_ - 1) {
-        // если у текущей ячейки нет правой стены
-        if ((grid_[i][j] & Wall::RIGHT) != Wall::RIGHT)
-          // добавляем ячейку справа от неё как соседа
-          graph_[vertices_[i][j].id].push_back(vertices_[i][j + 1].id);
-      }
-      if (i != 0) {
-        // если у ячейки сверху от текущей нет нижней стены
-        if ((grid_[i - 1][j] & Wall::DOWN) != Wall::DOWN)
-          // добавляем её как соседа для текущей ячейки
-          graph_[vertices_[i][j].id].push_back(vertices_[i - 1][j].id);
-      }
-      if (i != rows_ - 1) {
-        // если у текущей ячейки нет нижней стены
-        if ((grid_[i][j] & Wall::DOWN) != Wall::DOWN)
-          // добавляем ячейку снизу от неё как соседа
-          graph_[vertices_[i][j].id].push_back(vertices_[i + 1][j].id);
+std::vector<std::pair<int, int>> Maze::getSolution(int row1, int col1, int row2,
+                                                   int col2,
+                                                   SolverWorkspace &workspace,
+                                                   SolveMethod method) const {
+  if (isEmpty() || !isValidPoints(row1, col1, row2, col2)) return {};
+
+  // вычисляем номера вершин старта и финиша
+  int start_id = row1 * cols_ + col1;
+  int finish_id = row2 * cols_ + col2;
+
+  switch (method) {
+    case SolveMethod::BIDIRECTIONAL_BFS:
+      return solveBidirectional(start_id, finish_id, workspace);
+    case SolveMethod::A_STAR:
+      return solveAStar(start_id, finish_id, workspace,
+                        workspace.heapQueue());
+    case SolveMethod::A_STAR_BUCKET:
+      return solveAStar(start_id, finish_id, workspace,
+                        workspace.bucketQueue());
+    case SolveMethod::TREE_INDEX:
+      // лабиринт с петлями или изолированными областями решается обходом
+      if (buildTreeIndex())
+        return tree_index_.get(grid_).path(start_id, finish_id);
+      return solveBfs(start_id, finish_id, workspace);
+    default:
+      return solveBfs(start_id, finish_id, workspace);
+  }
+}
+
+std::vector<std::pair<int, int>> Maze::solveBfs(
+    int start_id, int finish_id, SolverWorkspace &workspace) const {
+  std::vector<std::pair<int, int>> path;
+  workspace.reset(rows_ * cols_);
+
+  // помещаем начальную точку в очередь
+  workspace.push(start_id);
+  workspace.visit(start_id, -1);
+
+  while (!workspace.queueEmpty()) {
+    int current = workspace.pop();
+    workspace.markExpanded();
+
+    if (current == finish_id) {
+      break;
+    }
+
+    // проверяем всех соседей, доступных без пересечения стен
+    int neighbors[4];
+    int count = grid_.neighbors(current / cols_, current % cols_, neighbors);
+    for (int k = 0; k < count; k++) {
+      int neighbor = neighbors[k];
+      if (!workspace.isVisited(neighbor)) {
+        workspace.visit(neighbor, current);
+        workspace.push(neighbor);
       }
     }
   }
+
+  // если конечная точка не была посещена, решения не существует
+  if (!workspace.isVisited(finish_id)) {
+    return path;
+  }
+
+  // восстанавливаем путь и разворачиваем его в обратном порядке
+  tracePath(finish_id, workspace, path);
+  std::reverse(path.begin(), path.end());
+  return path;
 }
 
-void Maze::indexVertices() {
-  int counter = 0;
-  for (int i = 0; i < rows_; i++) {
-    for (int j = 0; j < cols_; j++) {
-      vertices_[i][j].id = counter++;
-      vertices_[i][j].row = i;
-      vertices_[i][j].col = j;
+std::vector<std::pair<int, int>> Maze::solveBidirectional(
+    int start_id, int finish_id, SolverWorkspace &workspace) const {
+  std::vector<std::pair<int, int>> path;
+  if (start_id == finish_id) {
+    path.push_back(std::make_pair(start_id / cols_, start_id % cols_));
+    return path;
+  }
+
+  workspace.reset(rows_ * cols_, 2);
+  // фронт 0 растет от старта, фронт 1 - от финиша
+  workspace.visit(start_id, -1, 0);
+  workspace.push(start_id, 0);
+  workspace.visit(finish_id, -1, 1);
+  workspace.push(finish_id, 1);
+
+  // пара соседних ячеек разных фронтов, в которой фронты встретились
+  int meet[2] = {-1, -1};
+  while (meet[0] == -1 && !workspace.queueEmpty(0) &&
+         !workspace.queueEmpty(1)) {
+    // раскрываем целиком текущий уровень меньшего фронта
+    int side = workspace.queueSize(0) <= workspace.queueSize(1) ? 0 : 1;
+    for (int level = workspace.queueSize(side); level > 0 && meet[0] == -1;
+         level--) {
+      int current = workspace.pop(side);
+      workspace.markExpanded();
+      int neighbors[4];
+      int count = grid_.neighbors(current / cols_, current % cols_, neighbors);
+      for (int k = 0; k < count; k++) {
+        int neighbor = neighbors[k];
+        if (!workspace.isVisited(neighbor)) {
+          workspace.visit(neighbor, current, side);
+          workspace.push(neighbor, side);
+        } else if (workspace.side(neighbor) != side) {
+          // фронты встретились: все встречи на этом уровне дают путь одной
+          // длины, поэтому первая найденная - кратчайшая
+          meet[side] = current;
+          meet[1 - side] = neighbor;
+          break;
+        }
+      }
     }
   }
+
+  if (meet[0] == -1) return path;
+
+  // часть пути от старта до точки встречи
+  tracePath(meet[0], workspace, path);
+  std::reverse(path.begin(), path.end());
+  // часть пути от точки встречи до финиша
+  tracePath(meet[1], workspace, path);
+  return path;
 }
 
-std::vector<std::pair<int, int>> Maze::getSolution(int row1, int col1, int row2,
-                                                   int col2) {
-  std::vector<std::pair<int, int>> path;
+std::vector<std::vector<std::pair<int, int>>> Maze::solveBatch(
+    std::span<const Query> queries, SolveMethod method, int threads) const {
+  std::vector<std::vector<std::pair<int, int>>> paths(queries.size());
+  if (queries.empty()) return paths;
 
-  if (isEmpty() || !isValidPoints(row1, col1, row2, col2)) return path;
-  if (graph_.empty()) generateGraph();
+  if (threads <= 0) {
+    threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+  }
+  threads = std::min(threads, static_cast<int>(queries.size()));
 
-  std::queue<int> queue;
-  std::vector<bool> visited(rows_ * cols_, false);
-  std::vector<int> parent(rows_ * cols_, -1);
+  // потоки забирают запросы по одному из общего счетчика
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    SolverWorkspace workspace;
+    for (size_t i = next++; i < queries.size(); i = next++) {
+      const Query &query = queries[i];
+      paths[i] = getSolution(query.row1, query.col1, query.row2, query.col2,
+                             workspace, method);
+    }
+  };
 
-  // вычисляем номера вершин старта и финиша
-  int start_id = row1 * cols_ + col1;
-  int finish_id = row2 * cols_ + col2;
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread &thread : pool) thread.join();
+  return paths;
+}
 
-  // помещаем начальную точку в очередь
-  queue.push(start_id);
-  visited[start_id] = true;
+template <typename Queue>
+std::vector<std::pair<int, int>> Maze::solveAStar(int start_id, int finish_id,
+                                                  SolverWorkspace &workspace,
+                                                  Queue &queue) const {
+  std::vector<std::pair<int, int>> path;
+  workspace.reset(rows_ * cols_, 0, true);
+
+  int finish_row = finish_id / cols_;
+  int finish_col = finish_id % cols_;
+  // манхэттенское расстояние до финиша не превышает длину любого пути
+  auto heuristic = [&](int row, int col) {
+    return std::abs(row - finish_row) + std::abs(col - finish_col);
+  };
+
+  workspace.visit(start_id, -1);
+  workspace.setDistance(start_id, 0);
+  queue.push({heuristic(start_id / cols_, start_id % cols_), 0, start_id});
 
   while (!queue.empty()) {
-    int current = queue.front();
-    queue.pop();
+    OpenEntry entry = queue.pop();
+    // к ячейке уже найден более короткий путь, элемент устарел
+    if (entry.g != workspace.distance(entry.id)) continue;
+    workspace.markExpanded();
 
-    if (current == finish_id) {
+    if (entry.id == finish_id) {
       break;
     }
 
-    // проверяем всех соседей
-    for (int neighbor : graph_[current]) {
-      if (!visited[neighbor]) {
-        visited[neighbor] = true;
-        parent[neighbor] = current;
-        queue.push(neighbor);
+    int row = entry.id / cols_;
+    int col = entry.id % cols_;
+    int neighbors[4];
+    int count = grid_.neighbors(row, col, neighbors);
+    for (int k = 0; k < count; k++) {
+      int neighbor = neighbors[k];
+      int g = entry.g + 1;
+      if (!workspace.isVisited(neighbor) || g < workspace.distance(neighbor)) {
+        workspace.visit(neighbor, entry.id);
+        workspace.setDistance(neighbor, g);
+        queue.push(
+            {g + heuristic(neighbor / cols_, neighbor % cols_), g, neighbor});
       }
     }
   }
 
-  // если конечная точка не была посещена, решения не существует
-  int current = finish_id;
-  if (!visited[current]) {
-    return path;
-  }
+  if (!workspace.isVisited(finish_id)) return path;
 
-  // восстанавливаем путь
-  while (current != -1) {
-    path.push_back(std::make_pair(current / cols_, current % cols_));
-    current = parent[current];
-  }
-  // разворачиваем в обратном порядке
+  tracePath(finish_id, workspace, path);
   std::reverse(path.begin(), path.end());
   return path;
 }
 
-bool Maze::isEmpty() { return (rows_ == 0 || cols_ == 0); }
+void Maze::tracePath(int id, const SolverWorkspace &workspace,
+                     std::vector<std::pair<int, int>> &path) const {
+  while (id != -1) {
+    path.push_back(std::make_pair(id / cols_, id % cols_));
+    id = workspace.parent(id);
+  }
+}
+
+Maze::DistanceField Maze::getDistanceField(
+    const std::vector<std::pair<int, int>> &sources) const {
+  DistanceField field;
+  if (isEmpty()) return field;
+
+  int cells = rows_ * cols_;
+  field.rows = rows_;
+  field.cols = cols_;
+  field.distance.assign(cells, -1);
+  field.parent.assign(cells, -1);
+
+  // каждая ячейка попадает в очередь не более одного раза
+  std::vector<int> queue(cells);
+  int head = 0, tail = 0;
+  for (auto [row, col] : sources) {
+    if (!isValidPoints(row, col, row, col)) continue;
+    int id = row * cols_ + col;
+    if (field.distance[id] != -1) continue;
+    field.distance[id] = 0;
+    queue[tail++] = id;
+  }
+
+  while (head < tail) {
+    int current = queue[head++];
+    int neighbors[4];
+    int count = grid_.neighbors(current / cols_, current % cols_, neighbors);
+    for (int k = 0; k < count; k++) {
+      int neighbor = neighbors[k];
+      if (field.distance[neighbor] == -1) {
+        field.distance[neighbor] = field.distance[current] + 1;
+        field.parent[neighbor] = current;
+        queue[tail++] = neighbor;
+      }
+    }
+  }
+  return field;
+}
+
+bool Maze::buildTreeIndex() const { return tree_index_.get(grid_).isValid(); }
+
+int Maze::getPathLength(int row1, int col1, int row2, int col2) const {
+  if (isEmpty() || !isValidPoints(row1, col1, row2, col2)) return -1;
+  if (buildTreeIndex())
+    return tree_index_.get(grid_).pathLength(row1 * cols_ + col1,
+                                             row2 * cols_ + col2);
+  return static_cast<int>(getSolution(row1, col1, row2, col2).size()) - 1;
+}
+
+bool Maze::isEmpty() const { return (rows_ == 0 || cols_ == 0); }
 
-bool Maze::isValidPoints(int x1, int y1, int x2, int y2) {
+bool Maze::isValidPoints(int x1, int y1, int x2, int y2) const {
   bool is_valid = true;
   if (x1 < 0 || x1 >= rows_ || x2 < 0 || x2 >= rows_) is_valid = false;
   if (y1 < 0 || y1 >= cols_ || y2 < 0 || y2 >= cols_) is_valid = false;
@@ -1,109 +1,485 @@
 #include "../include/maze_builder.h"
 
+#include <atomic>
+#include <bit>
+#include <random>
+#include <thread>
+
 MazeBuilder::MazeBuilder()
-    : rows_(0), cols_(0), set_counter_(0), maze_(Maze(0, 0)) {
-  srand(time(NULL));
-}
+    : MazeBuilder((std::uint64_t{std::random_device{}()} << 32) |
+                  std::random_device{}()) {}
+
+MazeBuilder::MazeBuilder(std::uint64_t seed)
+    : rows_(0),
+      cols_(0),
+      seeds_(seed),
+      last_seed_(0),
+      kernel_(BIT_PARALLEL),
+      algorithm_(ELLER) {}
 
 Maze MazeBuilder::createMaze(int rows, int cols) {
+  return createMaze(rows, cols, seeds_.next());
+}
+
+Maze MazeBuilder::createMaze(int rows, int cols, std::uint64_t seed) {
+  if (rows < 1 || cols < 1) return Maze(0, 0);
+  Maze maze(rows, cols);
+  if (algorithm_ == WILSON || algorithm_ == KRUSKAL) {
+    // алгоритмы над всем лабиринтом строят его сразу на месте
+    last_seed_ = seed;
+    random_.reseed(seed);
+    resetMaze(rows, cols);
+    if (algorithm_ == WILSON)
+      createWilson(maze.grid_);
+    else
+      createKruskal(maze.grid_);
+    return maze;
+  }
+  // готовые строки сразу копируются в лабиринт
+  generate(rows, cols, seed, [&maze](int row, MazeGridView line) {
+    maze.grid_.copyRow(line, 0, row);
+    return true;
+  });
+  return maze;
+}
+
+Maze MazeBuilder::createMazeParallel(int rows, int cols, std::uint64_t seed,
+                                     int threads) {
+  last_seed_ = seed;
+  if (rows < 1 || cols < 1) return Maze(0, 0);
+  Maze maze(rows, cols);
+  int strips = (rows + STRIP_ROWS - 1) / STRIP_ROWS;
+
+  if (threads <= 0) {
+    threads = static_cast<int>(std::thread::hardware_concurrency());
+    threads = std::max(threads, 1);
+  }
+  threads = std::min(threads, strips);
+
+  // потоки забирают полосы по одной из общего счетчика и пишут каждую в свои
+  // строки лабиринта
+  std::atomic<int> next(0);
+  auto worker = [&]() {
+    MazeBuilder builder(0);
+    builder.setKernel(kernel_);
+    builder.setAlgorithm(algorithm_);
+    for (int strip = next++; strip < strips; strip = next++) {
+      int first_row = strip * STRIP_ROWS;
+      int strip_rows = std::min(STRIP_ROWS, rows - first_row);
+      builder.generate(strip_rows, cols, deriveSeed(seed, strip),
+                       [&maze, first_row](int row, MazeGridView line) {
+                         maze.grid_.copyRow(line, 0, first_row + row);
+                         return true;
+                       });
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+  worker();
+  for (std::thread &thread : pool) thread.join();
+
+  // полосы - отдельные деревья, один проход между соседними полосами
+  // соединяет их в остовное дерево всего лабиринта
+  for (int strip = 0; strip + 1 < strips; strip++) {
+    int row = (strip + 1) * STRIP_ROWS - 1;
+    maze.grid_.removeWalls(row, stripPassage(seed, strip, cols),
+                           Maze::Wall::DOWN);
+  }
+  return maze;
+}
+
+bool MazeBuilder::generate(int rows, int cols, const RowSink &sink) {
+  return generate(rows, cols, seeds_.next(), sink);
+}
+
+bool MazeBuilder::generate(int rows, int cols, std::uint64_t seed,
+                           const RowSink &sink) {
+  return generate(rows, cols, seed, 0, std::max(rows, 0), sink);
+}
+
+bool MazeBuilder::generate(int rows, int cols, std::uint64_t seed,
+                           int first_row, int count, const RowSink &sink) {
+  last_seed_ = seed;
+  random_.reseed(seed);
   resetMaze(rows, cols);
-  // создаем массив для хранения множеств
-  std::vector<std::vector<int>> cell_sets;
-  cell_sets.push_back(std::vector<int>(cols_, 0));
-
-  for (int i = 0; i < rows_; i++) {
-    assignUniqueSet(cell_sets[i]);
-    createRightWalls(cell_sets[i], i);
-    createDownWalls(cell_sets[i], i);
-    if (i == rows_ - 1) {
-      // обрабатываем последнюю строку
-      handleLastLine(cell_sets[i], i);
+  if (rows_ == 0) return false;
+  if (first_row < 0 || count < 0 || first_row + count > rows_) return false;
+  int end_row = first_row + count;
+
+  if (algorithm_ == WILSON || algorithm_ == KRUSKAL) {
+    MazeGrid grid(rows_, cols_);
+    if (algorithm_ == WILSON)
+      createWilson(grid);
+    else
+      createKruskal(grid);
+    for (int i = first_row; i < end_row; i++) {
+      MazeGridView line(1, cols_, grid.wordsPerRow(), grid.rightRow(i));
+      if (!sink(i, line)) return false;
+    }
+    return true;
+  }
+
+  // хранится только текущая строка, каждая строка обрабатывается за O(cols);
+  // алгоритм Эллера проходит и строки выше диапазона, не передавая их
+  int start_row = algorithm_ == ELLER ? 0 : first_row;
+  for (int i = start_row; i < end_row; i++) {
+    if (algorithm_ == SIDEWINDER)
+      createSidewinderRow(i);
+    else if (algorithm_ == BINARY_TREE)
+      createBinaryTreeRow(i);
+    else
+      createEllerRow(i);
+    if (i >= first_row && !sink(i, line_walls_.view())) return false;
+  }
+  return true;
+}
+
+MazeDescriptor MazeBuilder::describe(int rows, int cols, std::uint64_t seed,
+                                     bool strips) const {
+  MazeDescriptor descriptor = {};
+  descriptor.version = GENERATOR_VERSION;
+  descriptor.algorithm = algorithm_;
+  descriptor.rows = rows;
+  descriptor.cols = cols;
+  descriptor.seed = seed;
+  descriptor.flags = strips ? FLAG_STRIPS : 0;
+  return descriptor;
+}
+
+bool MazeBuilder::isValid(const MazeDescriptor &descriptor) {
+  return descriptor.version == GENERATOR_VERSION &&
+         descriptor.algorithm <= KRUSKAL && descriptor.rows > 0 &&
+         descriptor.cols > 0 &&
+         static_cast<std::int64_t>(descriptor.rows) * descriptor.cols <=
+             MazeGrid::MAX_CELLS &&
+         (descriptor.flags & ~FLAG_STRIPS) == 0;
+}
+
+Maze MazeBuilder::createMaze(const MazeDescriptor &descriptor) {
+  if (!isValid(descriptor)) return Maze(0, 0);
+  // алгоритм описания не должен заменять выбранный в этом строителе
+  MazeBuilder builder = descriptorBuilder(descriptor);
+  last_seed_ = descriptor.seed;
+  if (descriptor.flags & FLAG_STRIPS)
+    return builder.createMazeParallel(descriptor.rows, descriptor.cols,
+                                      descriptor.seed);
+  return builder.createMaze(descriptor.rows, descriptor.cols,
+                            descriptor.seed);
+}
+
+bool MazeBuilder::generate(const MazeDescriptor &descriptor, int first_row,
+                           int count, const RowSink &sink) {
+  if (!isValid(descriptor)) return false;
+  MazeBuilder builder = descriptorBuilder(descriptor);
+  last_seed_ = descriptor.seed;
+  int rows = descriptor.rows;
+  int cols = descriptor.cols;
+  if (!(descriptor.flags & FLAG_STRIPS))
+    return builder.generate(rows, cols, descriptor.seed, first_row, count,
+                            sink);
+  if (first_row < 0 || count < 0 || first_row + count > rows) return false;
+
+  // полосы независимы, генерируются только пересекающие диапазон
+  int end_row = first_row + count;
+  int strips = (rows + STRIP_ROWS - 1) / STRIP_ROWS;
+  MazeGrid boundary(1, cols);
+  bool complete = true;
+  for (int strip = first_row / STRIP_ROWS;
+       complete && strip * STRIP_ROWS < end_row; strip++) {
+    int strip_first = strip * STRIP_ROWS;
+    int strip_rows = std::min(STRIP_ROWS, rows - strip_first);
+    int from = std::max(first_row, strip_first) - strip_first;
+    int to = std::min(end_row, strip_first + strip_rows) - strip_first;
+    complete = builder.generate(
+        strip_rows, cols, deriveSeed(descriptor.seed, strip), from, to - from,
+        [&](int row, MazeGridView line) {
+          if (row != STRIP_ROWS - 1 || strip + 1 == strips)
+            return sink(strip_first + row, line);
+          // последняя строка полосы получает проход в следующую полосу
+          boundary.copyRow(line, 0, 0);
+          boundary.removeWalls(0, stripPassage(descriptor.seed, strip, cols),
+                               Maze::Wall::DOWN);
+          return sink(strip_first + row, boundary.view());
+        });
+  }
+  return complete;
+}
+
+MazeBuilder MazeBuilder::descriptorBuilder(
+    const MazeDescriptor &descriptor) const {
+  MazeBuilder builder(0);
+  builder.setKernel(kernel_);
+  builder.setAlgorithm(static_cast<Algorithm>(descriptor.algorithm));
+  return builder;
+}
+
+void MazeBuilder::createEllerRow(int cur_row) {
+  // переходим к следующей строке
+  if (cur_row != 0) deleteWalls();
+  drawRowBits();
+  assignUniqueSet();
+  if (kernel_ == BIT_PARALLEL) {
+    createRightWallsBitwise();
+    createDownWallsBitwise();
+  } else {
+    createRightWalls();
+    createDownWalls();
+  }
+  // обрабатываем последнюю строку
+  if (cur_row == rows_ - 1) handleLastLine();
+}
+
+void MazeBuilder::createSidewinderRow(int cur_row) {
+  random_.reseed(deriveSeed(last_seed_, cur_row));
+  drawRowBits();
+  std::uint64_t *right = line_walls_.rightRow(0);
+  std::uint64_t *down = line_walls_.downRow(0);
+  bool last_row = cur_row == rows_ - 1;
+  for (int w = 0; w < line_walls_.wordsPerRow(); w++) {
+    // стена справа закрывает отрезок, у последней ячейки она есть всегда
+    std::uint64_t cells = wordMask(w, cols_);
+    std::uint64_t last_col = cells & ~wordMask(w, cols_ - 1);
+    right[w] = last_row ? last_col : ((right_bits_[w] & cells) | last_col);
+    down[w] = cells;
+  }
+  if (last_row) return;
+
+  // каждый отрезок открывает проход вниз из одной случайной ячейки
+  int start = 0;
+  for (int w = 0; w < line_walls_.wordsPerRow(); w++) {
+    for (std::uint64_t ends = right[w]; ends; ends &= ends - 1) {
+      int end = w * MazeGrid::WORD_BITS + std::countr_zero(ends);
+      line_walls_.removeWalls(0, start + randomBelow(end - start + 1),
+                              Maze::Wall::DOWN);
+      start = end + 1;
+    }
+  }
+}
+
+void MazeBuilder::createBinaryTreeRow(int cur_row) {
+  random_.reseed(deriveSeed(last_seed_, cur_row));
+  drawRowBits();
+  std::uint64_t *right = line_walls_.rightRow(0);
+  std::uint64_t *down = line_walls_.downRow(0);
+  bool last_row = cur_row == rows_ - 1;
+  for (int w = 0; w < line_walls_.wordsPerRow(); w++) {
+    std::uint64_t cells = wordMask(w, cols_);
+    std::uint64_t last_col = cells & ~wordMask(w, cols_ - 1);
+    if (last_row) {
+      // последняя строка - коридор вправо
+      right[w] = last_col;
+      down[w] = cells;
     } else {
-      // добавляем строки
-      cell_sets.push_back(cell_sets[i]);
-      maze_.grid_[i + 1] = maze_.grid_[i];
-      deleteWalls(cell_sets[i + 1], i + 1);
+      // бит 1 - проход вниз, бит 0 - проход вправо, из последнего столбца
+      // проход всегда вниз
+      std::uint64_t go_down = (right_bits_[w] | last_col) & cells;
+      right[w] = go_down;
+      down[w] = ~go_down & cells;
     }
   }
-  return maze_;
 }
-void MazeBuilder::assignUniqueSet(std::vector<int>& line) {
+
+void MazeBuilder::createWilson(MazeGrid &grid) {
+  grid.fill(Maze::Wall::BOTH);
+  int cells = rows_ * cols_;
+  // next - направление последнего выхода из ячейки при блуждании,
+  // перезапись направления стирает петлю
+  std::vector<int> next(cells, NO_SET);
+  std::vector<char> in_tree(cells, 0);
+  in_tree[randomBelow(cells)] = 1;
+
+  for (int start = 0; start < cells; start++) {
+    for (int cur = start; !in_tree[cur]; cur = next[cur]) {
+      int row = cur / cols_, col = cur % cols_;
+      int neighbors[4];
+      int count = 0;
+      if (col > 0) neighbors[count++] = cur - 1;
+      if (col < cols_ - 1) neighbors[count++] = cur + 1;
+      if (row > 0) neighbors[count++] = cur - cols_;
+      if (row < rows_ - 1) neighbors[count++] = cur + cols_;
+      next[cur] = neighbors[randomBelow(count)];
+    }
+    // путь без петель присоединяется к дереву
+    for (int cur = start; !in_tree[cur]; cur = next[cur]) {
+      in_tree[cur] = 1;
+      removeWallBetween(grid, cur, next[cur]);
+    }
+  }
+}
+
+void MazeBuilder::createKruskal(MazeGrid &grid) {
+  grid.fill(Maze::Wall::BOTH);
+  int cells = rows_ * cols_;
+  // стена кодируется как номер ячейки * 2 + направление: 0 - справа,
+  // 1 - снизу
+  std::vector<int> walls;
+  walls.reserve(2 * static_cast<std::size_t>(cells));
+  for (int id = 0; id < cells; id++) {
+    if (id % cols_ != cols_ - 1) walls.push_back(2 * id);
+    if (id / cols_ != rows_ - 1) walls.push_back(2 * id + 1);
+  }
+  for (int i = static_cast<int>(walls.size()) - 1; i > 0; i--)
+    std::swap(walls[i], walls[randomBelow(i + 1)]);
+
+  // множества ячеек всего лабиринта ведутся той же системой
+  // непересекающихся множеств, что и множества строки в алгоритме Эллера
+  set_parent_.resize(cells);
+  open_cells_.assign(cells, 1);
+  for (int id = 0; id < cells; id++) set_parent_[id] = id;
+  for (int wall : walls) {
+    int a = wall / 2;
+    int b = (wall % 2) ? a + cols_ : a + 1;
+    if (findSet(a) != findSet(b)) {
+      mergeSets(a, b);
+      removeWallBetween(grid, a, b);
+    }
+  }
+}
+
+void MazeBuilder::removeWallBetween(MazeGrid &grid, int a, int b) const {
+  if (a > b) std::swap(a, b);
+  grid.removeWalls(a / cols_, a % cols_,
+                   b == a + cols_ ? Maze::Wall::DOWN : Maze::Wall::RIGHT);
+}
+
+std::uint64_t MazeBuilder::deriveSeed(std::uint64_t seed, int index) {
+  std::uint64_t state = static_cast<std::uint64_t>(index);
+  state = seed ^ MazeRandom::splitMix(state);
+  return MazeRandom::splitMix(state);
+}
+
+int MazeBuilder::stripPassage(std::uint64_t seed, int strip, int cols) {
+  std::uint64_t state = deriveSeed(seed, strip);
+  return static_cast<int>(MazeRandom::splitMix(state) % cols);
+}
+
+void MazeBuilder::drawRowBits() {
+  for (std::uint64_t &word : right_bits_) word = random_.next();
+  for (std::uint64_t &word : down_bits_) word = random_.next();
+}
+
+void MazeBuilder::assignUniqueSet() {
+  // номера множеств прошлой строки заменяются номерами их представителей,
+  // представители нумеруются заново в порядке появления в строке
+  std::fill(set_remap_.begin(), set_remap_.end(), NO_SET);
+  int set_counter = 0;
   for (int j = 0; j < cols_; j++) {
-    // если ячейка равна 0 (не входит ни в одно множество),
-    // присваиваем ей уникальное множество
-    if (line[j] == 0) {
-      line[j] = ++set_counter_;
+    if (line_[j] == NO_SET) {
+      // ячейка не входит ни в одно множество - присваиваем ей уникальное
+      line_[j] = set_counter++;
+    } else {
+      int root = findSet(line_[j]);
+      if (set_remap_[root] == NO_SET) set_remap_[root] = set_counter++;
+      line_[j] = set_remap_[root];
     }
   }
+  // каждое множество строки - отдельное дерево из одного узла
+  std::fill(open_cells_.begin(), open_cells_.begin() + set_counter, 0);
+  for (int set = 0; set < set_counter; set++) set_parent_[set] = set;
+  for (int j = 0; j < cols_; j++) open_cells_[line_[j]]++;
 }
-void MazeBuilder::createRightWalls(std::vector<int>& line, int cur_row) {
+
+void MazeBuilder::createRightWalls() {
   for (int i = 0; i < cols_ - 1; i++) {
     // решаем, добавлять ли правую стену
-    int wall = rand() % 2;
+    int wall = bitAt(right_bits_, i);
     if (wall == 0) {
       // если ячейки принадлежат одному множеству,
-      if (line[i] == line[i + 1])
+      if (findSet(line_[i]) == findSet(line_[i + 1]))
         // обязательно добавляем стену
-        maze_.grid_[cur_row][i] = maze_.grid_[cur_row][i] | Maze::Wall::RIGHT;
+        line_walls_.addWalls(0, i, Maze::Wall::RIGHT);
       else
         // объединяем множества
-        mergeSets(line, line[i], line[i + 1]);
+        mergeSets(line_[i], line_[i + 1]);
     } else {
       // wall == 1, добавляем стену
-      maze_.grid_[cur_row][i] = maze_.grid_[cur_row][i] | Maze::Wall::RIGHT;
+      line_walls_.addWalls(0, i, Maze::Wall::RIGHT);
     }
   }
   // к последней ячейке в строке добавляем правую стену
-  maze_.grid_[cur_row][cols_ - 1] =
-      maze_.grid_[cur_row][cols_ - 1] | Maze::Wall::RIGHT;
+  line_walls_.addWalls(0, cols_ - 1, Maze::Wall::RIGHT);
 }
 
-void MazeBuilder::mergeSets(std::vector<int>& line, int set1, int set2) {
-  for (int i = 0; i < cols_; i++) {
-    if (line[i] == set2) {
-      line[i] = set1;
-    }
+int MazeBuilder::findSet(int set) {
+  // сокращение пути делением пополам
+  while (set_parent_[set] != set) {
+    set_parent_[set] = set_parent_[set_parent_[set]];
+    set = set_parent_[set];
   }
+  return set;
 }
 
-void MazeBuilder::createDownWalls(std::vector<int>& line, int cur_row) {
+void MazeBuilder::mergeSets(int set1, int set2) {
+  int root1 = findSet(set1);
+  int root2 = findSet(set2);
+  if (root1 == root2) return;
+  // меньшее множество подвешивается к большему
+  if (open_cells_[root1] < open_cells_[root2]) std::swap(root1, root2);
+  set_parent_[root2] = root1;
+  open_cells_[root1] += open_cells_[root2];
+}
+
+void MazeBuilder::createDownWalls() {
   for (int i = 0; i < cols_; i++) {
-    int wall = rand() % 2;
+    int wall = bitAt(down_bits_, i);
     if (wall == 1) {
       // проверяем, что множество имеет больше одной ячейки без стены снизу
-      if (countAvailableCells(line, line[i], cur_row) > 1)
+      int root = findSet(line_[i]);
+      if (open_cells_[root] > 1) {
         // добавляем нижнюю стену
-        maze_.grid_[cur_row][i] = maze_.grid_[cur_row][i] | Maze::Wall::DOWN;
+        line_walls_.addWalls(0, i, Maze::Wall::DOWN);
+        open_cells_[root]--;
+      }
     }
   }
 }
 
-int MazeBuilder::countAvailableCells(std::vector<int>& line, int set,
-                                     int cur_row) {
-  int counter = 0;
-  for (int i = 0; i < cols_; i++) {
-    // если текущая ячейка принадлежит множеству не имеет стены снизу
-    if (line[i] == set &&
-        (maze_.grid_[cur_row][i] & Maze::Wall::DOWN) != Maze::Wall::DOWN)
-      counter++;
+void MazeBuilder::createRightWallsBitwise() {
+  std::uint64_t *walls = line_walls_.rightRow(0);
+  for (int w = 0; w < line_walls_.wordsPerRow(); w++) {
+    // у последней ячейки строки стена справа есть всегда
+    std::uint64_t inner = wordMask(w, cols_ - 1);
+    walls[w] = (right_bits_[w] & inner) | (wordMask(w, cols_) & ~inner);
+    // кандидаты на проход проверяются по порядку, так как объединение
+    // множеств влияет на следующие решения
+    for (std::uint64_t open = ~right_bits_[w] & inner; open; open &= open - 1) {
+      int i = w * MazeGrid::WORD_BITS + std::countr_zero(open);
+      if (findSet(line_[i]) == findSet(line_[i + 1]))
+        walls[w] |= open & -open;
+      else
+        mergeSets(line_[i], line_[i + 1]);
+    }
   }
-  return counter;
 }
 
-void MazeBuilder::deleteWalls(std::vector<int>& line, int cur_row) {
-  for (int i = 0; i < cols_; i++) {
-    // удаляем правую стену
-    maze_.grid_[cur_row][i] = maze_.grid_[cur_row][i] & ~Maze::Wall::RIGHT;
-    // если у ячейки есть нижняя стена
-    if ((maze_.grid_[cur_row][i] & Maze::Wall::DOWN) == Maze::Wall::DOWN) {
-      // присваиваем ячейке пустое множество
-      line[i] = 0;
-      // удаляем нижнюю стену
-      maze_.grid_[cur_row][i] = maze_.grid_[cur_row][i] & ~Maze::Wall::DOWN;
+void MazeBuilder::createDownWallsBitwise() {
+  std::uint64_t *walls = line_walls_.downRow(0);
+  for (int w = 0; w < line_walls_.wordsPerRow(); w++) {
+    for (std::uint64_t wanted = down_bits_[w] & wordMask(w, cols_); wanted;
+         wanted &= wanted - 1) {
+      // стена ставится, если в множестве останется ячейка без стены снизу
+      int root = findSet(line_[w * MazeGrid::WORD_BITS +
+                               std::countr_zero(wanted)]);
+      if (open_cells_[root] > 1) {
+        walls[w] |= wanted & -wanted;
+        open_cells_[root]--;
+      }
     }
   }
 }
 
+void MazeBuilder::deleteWalls() {
+  const std::uint64_t *down = line_walls_.downRow(0);
+  for (int w = 0; w < line_walls_.wordsPerRow(); w++) {
+    // ячейки под нижними стенами получают пустое множество
+    for (std::uint64_t bits = down[w]; bits; bits &= bits - 1)
+      line_[w * MazeGrid::WORD_BITS + std::countr_zero(bits)] = NO_SET;
+  }
+  // обе плоскости строки лежат подряд, очищаем их одним блоком
+  std::fill_n(line_walls_.rightRow(0), 2 * line_walls_.wordsPerRow(), 0);
+}
+
 void MazeBuilder::resetMaze(int rows, int cols) {
   // сбрасываем параметры предыдущего лабиринта и устанавливаем новые
   if (rows >= 1 && cols >= 1) {
@@ -113,23 +489,27 @@ void MazeBuilder::resetMaze(int rows, int cols) {
     rows_ = 0;
     cols_ = 0;
   }
-  set_counter_ = 0;
-  maze_ = Maze(rows_, cols_);
+  line_.assign(cols_, NO_SET);
+  set_parent_.assign(cols_, 0);
+  open_cells_.assign(cols_, 0);
+  set_remap_.assign(cols_, NO_SET);
+  line_walls_ = MazeGrid(1, cols_);
+  right_bits_.assign(line_walls_.wordsPerRow(), 0);
+  down_bits_.assign(line_walls_.wordsPerRow(), 0);
 }
 
-void MazeBuilder::handleLastLine(std::vector<int>& line, int cur_row) {
+void MazeBuilder::handleLastLine() {
   for (int j = 0; j < cols_ - 1; j++) {
     // добавляем стену снизу
-    maze_.grid_[cur_row][j] = maze_.grid_[cur_row][j] | Maze::Wall::DOWN;
+    line_walls_.addWalls(0, j, Maze::Wall::DOWN);
     // если множество текущей клетки и следующей не совпадают
-    if (line[j] != line[j + 1]) {
+    if (findSet(line_[j]) != findSet(line_[j + 1])) {
       // удаляем правую стену
-      maze_.grid_[cur_row][j] = maze_.grid_[cur_row][j] & ~Maze::Wall::RIGHT;
+      line_walls_.removeWalls(0, j, Maze::Wall::RIGHT);
       // объединяем множества
-      mergeSets(line, line[j], line[j + 1]);
+      mergeSets(line_[j], line_[j + 1]);
     }
   }
   // нижней правой ячейке добавляем стены справа и снизу
-  maze_.grid_[cur_row][cols_ - 1] =
-      maze_.grid_[cur_row][cols_ - 1] | Maze::Wall::BOTH;
-}
\ No newline at end of file
+  line_walls_.addWalls(0, cols_ - 1, Maze::Wall::BOTH);
+}
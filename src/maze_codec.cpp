@@ -0,0 +1,349 @@
+#include "../include/maze_codec.h"
+
+#include <algorithm>
+
+namespace {
+
+/// Количество бит точности вероятностей
+constexpr int PROB_BITS = 11;
+/// Вероятность 1/2
+constexpr std::uint16_t PROB_HALF = 1 << (PROB_BITS - 1);
+/// Скорость адаптации вероятностей
+constexpr int ADAPT_SHIFT = 5;
+/// Граница нормализации интервала кодера
+constexpr std::uint32_t TOP = 1u << 24;
+
+/**
+ * @struct Model
+ * @brief Вероятности нулевого бита для каждого контекста
+ */
+struct Model {
+  std::uint16_t right[32];  ///< Контексты стен справа
+  std::uint16_t down[64];   ///< Контексты стен снизу
+
+  Model() {
+    std::fill(std::begin(right), std::end(right), PROB_HALF);
+    std::fill(std::begin(down), std::end(down), PROB_HALF);
+  }
+};
+
+/**
+ * @class RangeEncoder
+ * @brief Двоичный арифметический кодер с переносом через кэш байта
+ */
+class RangeEncoder {
+ public:
+  explicit RangeEncoder(std::vector<std::uint8_t> &out) : out_(out) {}
+
+  /// Кодирует бит и обновляет его вероятность
+  void code(std::uint16_t &prob, int bit) {
+    std::uint32_t bound = (range_ >> PROB_BITS) * prob;
+    if (bit == 0) {
+      range_ = bound;
+      prob += ((1 << PROB_BITS) - prob) >> ADAPT_SHIFT;
+    } else {
+      low_ += bound;
+      range_ -= bound;
+      prob -= prob >> ADAPT_SHIFT;
+    }
+    while (range_ < TOP) {
+      range_ <<= 8;
+      shiftLow();
+    }
+  }
+
+  /// Выталкивает оставшиеся байты состояния
+  void finish() {
+    for (int i = 0; i < 5; i++) shiftLow();
+  }
+
+ private:
+  /// Выводит старший байт нижней границы с учетом переноса
+  void shiftLow() {
+    if (static_cast<std::uint32_t>(low_) < 0xFF000000u || (low_ >> 32) != 0) {
+      std::uint8_t carry = static_cast<std::uint8_t>(low_ >> 32);
+      std::uint8_t byte = cache_;
+      do {
+        out_.push_back(static_cast<std::uint8_t>(byte + carry));
+        byte = 0xFF;
+      } while (--cache_size_ != 0);
+      cache_ = static_cast<std::uint8_t>(low_ >> 24);
+    }
+    cache_size_++;
+    low_ = (low_ & 0x00FFFFFF) << 8;
+  }
+
+  /// выходной буфер
+  std::vector<std::uint8_t> &out_;
+  /// нижняя граница интервала
+  std::uint64_t low_ = 0;
+  /// ширина интервала
+  std::uint32_t range_ = 0xFFFFFFFF;
+  /// отложенный байт, который может измениться при переносе
+  std::uint8_t cache_ = 0;
+  /// количество отложенных байт
+  std::uint64_t cache_size_ = 1;
+};
+
+/**
+ * @class RangeDecoder
+ * @brief Декодер для RangeEncoder
+ */
+class RangeDecoder {
+ public:
+  RangeDecoder(const std::uint8_t *data, std::size_t size)
+      : data_(data), size_(size) {
+    for (int i = 0; i < 5; i++) code_ = (code_ << 8) | nextByte();
+  }
+
+  /// Декодирует бит и обновляет его вероятность
+  int code(std::uint16_t &prob) {
+    std::uint32_t bound = (range_ >> PROB_BITS) * prob;
+    int bit = 0;
+    if (code_ < bound) {
+      range_ = bound;
+      prob += ((1 << PROB_BITS) - prob) >> ADAPT_SHIFT;
+    } else {
+      code_ -= bound;
+      range_ -= bound;
+      prob -= prob >> ADAPT_SHIFT;
+      bit = 1;
+    }
+    while (range_ < TOP) {
+      range_ <<= 8;
+      code_ = (code_ << 8) | nextByte();
+    }
+    return bit;
+  }
+
+  /// Проверяет, что прочитаны ровно все сжатые данные: кодер выводит столько
+  /// же байт, сколько декодер читает при разборе тех же бит
+  bool consumedAll() const { return pos_ == size_; }
+
+ private:
+  /// Читает следующий байт, за концом данных - нули. Позиция растет и за
+  /// концом, чтобы недостаток данных был заметен
+  std::uint32_t nextByte() {
+    std::uint32_t byte = pos_ < size_ ? data_[pos_] : 0;
+    pos_++;
+    return byte;
+  }
+
+  /// сжатые данные
+  const std::uint8_t *data_;
+  /// размер сжатых данных
+  std::size_t size_;
+  /// позиция чтения
+  std::size_t pos_ = 0;
+  /// смещение кода внутри интервала
+  std::uint32_t code_ = 0;
+  /// ширина интервала
+  std::uint32_t range_ = 0xFFFFFFFF;
+};
+
+/// Возвращает бит ячейки col из слов строки, за границами строки - 0
+inline int bitAt(const std::uint64_t *words, int col, int cols) {
+  if (col < 0 || col >= cols) return 0;
+  return (words[col / MazeGrid::WORD_BITS] >> (col % MazeGrid::WORD_BITS)) & 1;
+}
+
+/**
+ * @class SetTracker
+ * @brief Множества ячеек текущей строки, уже связанных проходами внутри
+ * блока, - та же разметка, что в алгоритме Эллера.
+ *
+ * В идеальном лабиринте проход между уже связанными ячейками невозможен, а
+ * множество без единого прохода вниз отрезано от следующих строк, поэтому
+ * такие стены предсказываются почти без затрат. Для лабиринтов с петлями
+ * предсказание просто хуже, но кодирование остается точным.
+ */
+class SetTracker {
+ public:
+  explicit SetTracker(int cols)
+      : cols_(cols),
+        label_(cols),
+        parent_(cols),
+        remaining_(cols),
+        opened_(cols),
+        remap_(cols) {}
+
+  /// Начинает строку: ячейки под проходами наследуют множество ячейки сверху
+  void startRow(const std::uint64_t *prev_down, bool first) {
+    std::fill(remap_.begin(), remap_.end(), -1);
+    int counter = 0;
+    for (int c = 0; c < cols_; c++) {
+      if (first || bitAt(prev_down, c, cols_)) {
+        label_[c] = counter++;
+      } else {
+        int root = find(label_[c]);
+        if (remap_[root] == -1) remap_[root] = counter++;
+        label_[c] = remap_[root];
+      }
+    }
+    for (int set = 0; set < counter; set++) parent_[set] = set;
+  }
+
+  /// Проверяет, связаны ли ячейки строки
+  bool connected(int a, int b) { return find(label_[a]) == find(label_[b]); }
+
+  /// Объединяет множества ячеек строки
+  void merge(int a, int b) { parent_[find(label_[a])] = find(label_[b]); }
+
+  /// Подсчитывает ячейки множеств перед обработкой стен снизу
+  void startDown() {
+    std::fill(remaining_.begin(), remaining_.end(), 0);
+    std::fill(opened_.begin(), opened_.end(), 0);
+    for (int c = 0; c < cols_; c++) remaining_[find(label_[c])]++;
+  }
+
+  /// Проверяет, что ячейка - последний шанс множества открыть проход вниз
+  bool lastChance(int c) {
+    int root = find(label_[c]);
+    return remaining_[root] == 1 && opened_[root] == 0;
+  }
+
+  /// Учитывает обработанную стену снизу ячейки
+  void pass(int c, bool open) {
+    int root = find(label_[c]);
+    remaining_[root]--;
+    if (open) opened_[root]++;
+  }
+
+ private:
+  /// Находит представителя множества с сокращением пути
+  int find(int set) {
+    while (parent_[set] != set) {
+      parent_[set] = parent_[parent_[set]];
+      set = parent_[set];
+    }
+    return set;
+  }
+
+  /// количество столбцов
+  int cols_;
+  /// множество каждой ячейки строки
+  std::vector<int> label_;
+  /// родители множеств
+  std::vector<int> parent_;
+  /// для представителя: необработанные ячейки множества в строке
+  std::vector<int> remaining_;
+  /// для представителя: открытые проходы вниз
+  std::vector<int> opened_;
+  /// новые номера множеств при переходе к строке
+  std::vector<int> remap_;
+};
+
+/**
+ * @brief Кодирует или декодирует одну строку. Сначала обрабатываются стены
+ * справа, затем снизу; контекст бита составляют уже обработанные соседние
+ * стены и связность ячеек.
+ * @param[in] prev_right стены справа предыдущей строки
+ * @param[in] prev_down стены снизу предыдущей строки
+ * @param[in,out] right стены справа строки
+ * @param[in,out] down стены снизу строки
+ * @param[in] cols количество столбцов
+ * @param[in] first_row true для первой строки блока
+ * @param[in] last_row true для последней строки лабиринта
+ * @param[in,out] model вероятности контекстов
+ * @param[in,out] sets множества ячеек
+ * @param[in] code функция кодирования бита: (вероятность, слово, номер
+ * бита), возвращает значение бита
+ */
+template <typename CodeBit>
+void codeRow(const std::uint64_t *prev_right, const std::uint64_t *prev_down,
+             std::uint64_t *right, std::uint64_t *down, int cols,
+             bool first_row, bool last_row, Model &model, SetTracker &sets,
+             CodeBit code) {
+  sets.startRow(prev_down, first_row);
+  for (int c = 0; c < cols; c++) {
+    bool inner = c != cols - 1;
+    bool connected = inner && sets.connected(c, c + 1);
+    int context = bitAt(right, c - 1, cols) |
+                  bitAt(prev_right, c, cols) << 1 |
+                  bitAt(prev_down, c, cols) << 2 | !inner << 3 |
+                  connected << 4;
+    int bit = code(model.right[context], right[c / MazeGrid::WORD_BITS],
+                   c % MazeGrid::WORD_BITS);
+    if (inner && bit == 0 && !connected) sets.merge(c, c + 1);
+  }
+
+  sets.startDown();
+  for (int c = 0; c < cols; c++) {
+    int context = bitAt(down, c - 1, cols) | bitAt(right, c, cols) << 1 |
+                  bitAt(right, c - 1, cols) << 2 |
+                  bitAt(prev_down, c, cols) << 3 | last_row << 4 |
+                  sets.lastChance(c) << 5;
+    int bit = code(model.down[context], down[c / MazeGrid::WORD_BITS],
+                   c % MazeGrid::WORD_BITS);
+    sets.pass(c, bit == 0);
+  }
+}
+
+/**
+ * @brief Кодирует строки хранилища
+ * @param[in] grid стены строк
+ * @param[in] first_row первая строка блока в хранилище
+ * @param[in] count количество строк блока
+ * @param[in] last_row номер последней строки лабиринта в хранилище
+ * @return Сжатые данные блока
+ */
+std::vector<std::uint8_t> encode(MazeGridView grid, int first_row, int count,
+                                 int last_row) {
+  std::vector<std::uint8_t> out;
+  RangeEncoder encoder(out);
+  Model model;
+  SetTracker sets(grid.cols());
+  int words = grid.wordsPerRow();
+  // строка перед блоком считается пустой, чтобы блок не зависел от соседей
+  std::vector<std::uint64_t> prev(2 * words, 0);
+  std::vector<std::uint64_t> row(2 * words, 0);
+
+  for (int r = first_row; r < first_row + count; r++) {
+    std::copy(grid.rightRow(r), grid.rightRow(r) + 2 * words, row.begin());
+    codeRow(prev.data(), prev.data() + words, row.data(), row.data() + words,
+            grid.cols(), r == first_row, r == last_row, model, sets,
+            [&encoder](std::uint16_t &prob, std::uint64_t &word, int bit) {
+              int value = (word >> bit) & 1;
+              encoder.code(prob, value);
+              return value;
+            });
+    prev.swap(row);
+  }
+  encoder.finish();
+  return out;
+}
+
+}  // namespace
+
+std::vector<std::uint8_t> MazeCodec::encodeRows(MazeGridView grid,
+                                                int first_row, int count) {
+  return encode(grid, first_row, count, grid.rows() - 1);
+}
+
+std::vector<std::uint8_t> MazeCodec::encodeBlock(MazeGridView block,
+                                                 int first_row,
+                                                 int total_rows) {
+  return encode(block, 0, block.rows(), total_rows - 1 - first_row);
+}
+
+bool MazeCodec::decodeRows(const std::uint8_t *data, std::size_t size,
+                           int first_row, int total_rows, MazeGrid &out) {
+  RangeDecoder decoder(data, size);
+  Model model;
+  SetTracker sets(out.cols());
+  int words = out.wordsPerRow();
+  std::vector<std::uint64_t> empty(2 * words, 0);
+
+  for (int r = 0; r < out.rows(); r++) {
+    const std::uint64_t *prev = r == 0 ? empty.data() : out.rightRow(r - 1);
+    std::fill_n(out.rightRow(r), 2 * words, 0);
+    codeRow(prev, prev + words, out.rightRow(r), out.downRow(r), out.cols(),
+            r == 0, first_row + r == total_rows - 1, model, sets,
+            [&decoder](std::uint16_t &prob, std::uint64_t &word, int bit) {
+              int value = decoder.code(prob);
+              word |= std::uint64_t(value) << bit;
+              return value;
+            });
+  }
+  return decoder.consumedAll();
+}
@@ -0,0 +1,107 @@
+#include "../include/maze_compressed_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "../include/maze_codec.h"
+
+MazeCompressedWriter::MazeCompressedWriter(const std::string file_path,
+                                           int rows, int cols,
+                                           std::optional<std::uint64_t> seed,
+                                           int block_rows)
+    : file_path_(file_path),
+      rows_(rows),
+      cols_(cols),
+      seed_(seed),
+      block_rows_(block_rows),
+      next_row_(0),
+      offset_(0),
+      checksum_(MazeSerializer::CHECKSUM_BASIS),
+      failed_(true) {
+  if (rows < 1 || cols < 1 || block_rows < 1) return;
+  if (!MazeSerializer::isLittleEndianHost(file_path)) return;
+  file_.open(file_path, std::ios::binary);
+  if (!file_) {
+    std::cerr << "Cannot write to file:" + file_path << '\n';
+    return;
+  }
+
+  block_ = MazeGrid(std::min(block_rows, rows), cols);
+  int blocks = (rows + block_rows - 1) / block_rows;
+  offsets_.reserve(blocks + 1);
+  // заголовок и таблица смещений дописываются в finish
+  offset_ = sizeof(MazeFileHeader) + (blocks + 1) * sizeof(std::uint64_t);
+  file_.seekp(offset_);
+  failed_ = !file_;
+}
+
+bool MazeCompressedWriter::append(int row, MazeGridView line) {
+  if (failed_ || row != next_row_ || row >= rows_ || line.cols() != cols_ ||
+      line.rows() < 1)
+    return false;
+  block_.copyRow(line, 0, row % block_rows_);
+  checksum_ = MazeSerializer::checksum(
+      MazeGridView(1, cols_, line.wordsPerRow(), line.rightRow(0)),
+      checksum_);
+  next_row_++;
+  if (next_row_ % block_rows_ == 0 || next_row_ == rows_) writeBlock();
+  return !failed_;
+}
+
+MazeRowSink MazeCompressedWriter::sink() {
+  return [this](int row, MazeGridView line) { return append(row, line); };
+}
+
+bool MazeCompressedWriter::finish() {
+  if (failed_ || next_row_ != rows_) return false;
+  offsets_.push_back(offset_);
+
+  MazeFileHeader header = {};
+  std::memcpy(header.magic, MazeSerializer::COMPRESSED_MAGIC,
+              sizeof(header.magic));
+  header.version = MazeSerializer::BINARY_VERSION;
+  header.header_size = sizeof(MazeFileHeader);
+  header.rows = rows_;
+  header.cols = cols_;
+  header.words_per_row = block_.wordsPerRow();
+  header.flags = MazeSerializer::FLAG_BLOCK_CHECKSUMS;
+  if (seed_) header.flags |= MazeSerializer::FLAG_HAS_SEED;
+  header.seed = seed_.value_or(0);
+  header.payload_size = offset_ - sizeof(MazeFileHeader);
+  header.checksum = checksum_;
+  header.block_rows = block_rows_;
+
+  file_.seekp(0);
+  file_.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file_.write(reinterpret_cast<const char *>(offsets_.data()),
+              offsets_.size() * sizeof(std::uint64_t));
+  file_.close();
+  // повторный вызов и новые строки после завершения отвергаются
+  failed_ = true;
+  if (!file_) {
+    std::cerr << "Cannot write to file:" + file_path_ << '\n';
+    return false;
+  }
+  return true;
+}
+
+void MazeCompressedWriter::writeBlock() {
+  int count = (next_row_ - 1) % block_rows_ + 1;
+  int first_row = next_row_ - count;
+  MazeGridView rows(count, cols_, block_.wordsPerRow(), block_.rightRow(0));
+  std::vector<std::uint8_t> data =
+      MazeCodec::encodeBlock(rows, first_row, rows_);
+  // контрольная сумма блока позволяет проверить его отдельно от файла
+  std::uint64_t block_checksum = MazeSerializer::checksum(rows);
+  const std::uint8_t *bytes =
+      reinterpret_cast<const std::uint8_t *>(&block_checksum);
+  data.insert(data.end(), bytes, bytes + sizeof(block_checksum));
+  file_.write(reinterpret_cast<const char *>(data.data()), data.size());
+  offsets_.push_back(offset_);
+  offset_ += data.size();
+  if (!file_) {
+    std::cerr << "Cannot write to file:" + file_path_ << '\n';
+    failed_ = true;
+  }
+}
@@ -0,0 +1,104 @@
+#include "../include/maze_grid.h"
+
+#include <algorithm>
+
+MazeGrid::MazeGrid()
+    : rows_(0), cols_(0), words_per_row_(0), data_(nullptr) {}
+
+MazeGrid::MazeGrid(int rows, int cols) : MazeGrid() {
+  if (rows < 1 || cols < 1) return;
+  rows_ = rows;
+  cols_ = cols;
+  words_per_row_ = (cols + WORD_BITS - 1) / WORD_BITS;
+  words_.assign(static_cast<std::size_t>(2 * rows_) * words_per_row_, 0);
+  data_ = words_.data();
+}
+
+MazeGrid::MazeGrid(int rows, int cols, std::uint64_t *words,
+                   std::shared_ptr<void> storage)
+    : MazeGrid() {
+  if (rows < 1 || cols < 1 || words == nullptr) return;
+  rows_ = rows;
+  cols_ = cols;
+  words_per_row_ = (cols + WORD_BITS - 1) / WORD_BITS;
+  data_ = words;
+  storage_ = std::move(storage);
+}
+
+MazeGrid::MazeGrid(const MazeGrid &other)
+    : rows_(other.rows_),
+      cols_(other.cols_),
+      words_per_row_(other.words_per_row_),
+      words_(other.data_, other.data_ + other.wordCount()),
+      data_(words_.data()) {}
+
+MazeGrid::MazeGrid(MazeGrid &&other) noexcept : MazeGrid() {
+  *this = std::move(other);
+}
+
+MazeGrid &MazeGrid::operator=(const MazeGrid &other) {
+  if (this != &other) *this = MazeGrid(other);
+  return *this;
+}
+
+MazeGrid &MazeGrid::operator=(MazeGrid &&other) noexcept {
+  if (this == &other) return *this;
+  rows_ = other.rows_;
+  cols_ = other.cols_;
+  words_per_row_ = other.words_per_row_;
+  // перемещение вектора сохраняет адрес его буфера
+  words_ = std::move(other.words_);
+  data_ = other.storage_ ? other.data_ : words_.data();
+  storage_ = std::move(other.storage_);
+  // источник остается пустым хранилищем
+  other.rows_ = other.cols_ = other.words_per_row_ = 0;
+  other.words_.clear();
+  other.data_ = nullptr;
+  return *this;
+}
+
+bool MazeGrid::operator==(const MazeGrid &other) const {
+  if (rows_ != other.rows_ || cols_ != other.cols_) return false;
+  return std::equal(data_, data_ + wordCount(), other.data_);
+}
+
+void MazeGrid::set(int row, int col, int walls) {
+  removeWalls(row, col, Wall::BOTH);
+  addWalls(row, col, walls);
+}
+
+void MazeGrid::addWalls(int row, int col, int walls) {
+  std::uint64_t mask = std::uint64_t{1} << (col % WORD_BITS);
+  if (walls & Wall::RIGHT) rightRow(row)[col / WORD_BITS] |= mask;
+  if (walls & Wall::DOWN) downRow(row)[col / WORD_BITS] |= mask;
+}
+
+void MazeGrid::removeWalls(int row, int col, int walls) {
+  std::uint64_t mask = ~(std::uint64_t{1} << (col % WORD_BITS));
+  if (walls & Wall::RIGHT) rightRow(row)[col / WORD_BITS] &= mask;
+  if (walls & Wall::DOWN) downRow(row)[col / WORD_BITS] &= mask;
+}
+
+void MazeGrid::fill(int walls) {
+  // биты за последним столбцом строки остаются нулевыми
+  int tail = cols_ % WORD_BITS;
+  std::uint64_t all = ~std::uint64_t{0};
+  std::uint64_t last = tail ? (std::uint64_t{1} << tail) - 1 : all;
+  for (int row = 0; row < rows_; row++) {
+    for (int w = 0; w < words_per_row_; w++) {
+      std::uint64_t mask = w == words_per_row_ - 1 ? last : all;
+      rightRow(row)[w] = (walls & Wall::RIGHT) ? mask : 0;
+      downRow(row)[w] = (walls & Wall::DOWN) ? mask : 0;
+    }
+  }
+}
+
+void MazeGrid::copyRow(int from, int to) {
+  // обе плоскости строки лежат подряд, копируем их одним блоком
+  std::copy(rightRow(from), rightRow(from) + 2 * words_per_row_, rightRow(to));
+}
+
+void MazeGrid::copyRow(MazeGridView source, int from, int to) {
+  const std::uint64_t *begin = source.rightRow(from);
+  std::copy(begin, begin + 2 * words_per_row_, rightRow(to));
+}
@@ -1,84 +1,544 @@
 #include "../include/maze_serializer.h"
 
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+#include "../include/maze_codec.h"
+#include "../include/maze_compressed_writer.h"
+
+#ifdef _WIN32
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @class TextScanner
+ * @brief Разбор целых чисел текстового формата лабиринта из буфера в памяти.
+ * Отслеживает строку и столбец для сообщений об ошибках.
+ */
+class TextScanner {
+ public:
+  /**
+   * @brief Конструктор
+   * @param[in] begin начало буфера
+   * @param[in] end конец буфера
+   */
+  TextScanner(const char *begin, const char *end)
+      : pos_(begin), end_(end), line_start_(begin), line_(1) {}
+
+  /**
+   * @brief Считывает следующее целое число
+   * @param[out] value число
+   * @return true, если число считано
+   */
+  bool next(int &value) {
+    skipSpaces();
+    auto [ptr, error] = std::from_chars(pos_, end_, value);
+    if (error != std::errc() || (ptr != end_ && !isSpace(*ptr))) return false;
+    pos_ = ptr;
+    return true;
+  }
+
+  /**
+   * @brief Считывает строку матрицы стен в битовую строку: ненулевое число -
+   * установленный бит
+   * @param[out] words слова битовой строки
+   * @param[in] count количество чисел в строке матрицы
+   * @return true, если все числа считаны
+   */
+  bool nextBits(std::uint64_t *words, int count) {
+    skipSpaces();
+    if (nextBitsFast(words, count)) return true;
+
+    // произвольные пробелы и числа разбираются по одному
+    std::uint64_t word = 0;
+    for (int j = 0; j < count; j++) {
+      int value = 0;
+      if (!next(value)) return false;
+      word |= std::uint64_t{value != 0} << (j % MazeGrid::WORD_BITS);
+      if ((j + 1) % MazeGrid::WORD_BITS == 0 || j == count - 1) {
+        words[j / MazeGrid::WORD_BITS] = word;
+        word = 0;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Описывает текущую позицию для сообщения об ошибке
+   * @return Строка вида "строка:столбец: причина"
+   */
+  std::string error() const {
+    std::string position = std::to_string(line_) + ":" +
+                           std::to_string(pos_ - line_start_ + 1) + ": ";
+    return position +
+           (pos_ == end_ ? "unexpected end of file" : "expected integer");
+  }
+
+ private:
+  /**
+   * @brief Разбирает строку матрицы в том виде, в котором её записывает
+   * saveToFile: цифры 0 и 1 через пробел и перевод строки в конце.
+   * @param[out] words слова битовой строки
+   * @param[in] count количество чисел в строке матрицы
+   * @return true, если строка имеет такой вид и разобрана, иначе false и
+   * позиция не меняется
+   */
+  bool nextBitsFast(std::uint64_t *words, int count) {
+    if (end_ - pos_ < 2 * static_cast<std::ptrdiff_t>(count)) return false;
+    const char *p = pos_;
+    std::uint64_t word = 0;
+    for (int j = 0; j < count; j++, p += 2) {
+      unsigned bit = static_cast<unsigned char>(p[0]) - '0';
+      bool separator =
+          j == count - 1 ? (p[1] == '\n' || p[1] == '\r') : p[1] == ' ';
+      if (bit > 1 || !separator) return false;
+      word |= std::uint64_t{bit} << (j % MazeGrid::WORD_BITS);
+      if ((j + 1) % MazeGrid::WORD_BITS == 0 || j == count - 1) {
+        words[j / MazeGrid::WORD_BITS] = word;
+        word = 0;
+      }
+    }
+    // перевод строки учтет следующий пропуск пробелов
+    pos_ = p - 1;
+    return true;
+  }
+
+  /// Пропускает пробельные символы, считая переводы строк
+  void skipSpaces() {
+    for (; pos_ != end_ && isSpace(*pos_); pos_++) {
+      if (*pos_ == '\n') {
+        line_++;
+        line_start_ = pos_ + 1;
+      }
+    }
+  }
+
+  /// Проверяет, является ли символ пробельным (как isspace в локали "C")
+  static bool isSpace(char c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+  /// текущая позиция
+  const char *pos_;
+  /// конец буфера
+  const char *end_;
+  /// начало текущей строки
+  const char *line_start_;
+  /// номер текущей строки
+  int line_;
+};
+
+/// Размер буфера записи текстового файла
+constexpr std::size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+}  // namespace
+
 Maze MazeSerializer::readFromFile(const std::string file_path) {
-  std::ifstream file;
-  file.open(file_path);
+  std::ifstream file(file_path, std::ios::binary | std::ios::ate);
   if (!file) {
     std::cerr << "Cannot open file: " + file_path << '\n';
     return Maze(0, 0);
   }
+  std::size_t file_size = file.tellg();
+  file.seekg(0);
+
+  // двоичный, сжатый файлы и описание узнаются по сигнатуре
+  char magic[sizeof(BINARY_MAGIC)] = {};
+  if (file.read(magic, sizeof(magic))) {
+    if (std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0 ||
+        std::memcmp(magic, COMPRESSED_MAGIC, sizeof(magic)) == 0) {
+      file.close();
+      return readFromBinaryFile(file_path, true);
+    }
+    if (std::memcmp(magic, DESCRIPTOR_MAGIC, sizeof(magic)) == 0) {
+      file.close();
+      return readFromDescriptorFile(file_path);
+    }
+  }
+
+  // текстовый файл читается целиком одним блоком
+  auto text = std::make_unique_for_overwrite<char[]>(file_size);
+  file.clear();
+  file.seekg(0);
+  if (!file.read(text.get(), file_size)) {
+    std::cerr << "Cannot read file: " + file_path << '\n';
+    return Maze(0, 0);
+  }
+  file.close();
+
+  TextScanner scanner(text.get(), text.get() + file_size);
   int rows = 0, cols = 0;
-  if (!(file >> rows) || !(file >> cols) || rows <= 0 || cols <= 0) {
-    file.close();
+  if (!scanner.next(rows) || !scanner.next(cols)) {
+    std::cerr << file_path + ":" + scanner.error() << '\n';
     return Maze(0, 0);
   }
+  if (rows <= 0 || cols <= 0) return Maze(0, 0);
 
   Maze maze(rows, cols);
 
-  // считывание первой матрицы с правыми стенами
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      int temp = 0;
-      if (!(file >> temp)) {
-        file.close();
+  // первая матрица - правые стены, вторая - нижние; ненулевое число - стена
+  for (int plane = 0; plane < 2; plane++) {
+    for (int i = 0; i < rows; i++) {
+      std::uint64_t *words =
+          plane == 0 ? maze.grid_.rightRow(i) : maze.grid_.downRow(i);
+      if (!scanner.nextBits(words, cols)) {
+        std::cerr << file_path + ":" + scanner.error() << '\n';
         return Maze(0, 0);
       }
-      maze.grid_[i][j] = temp;
     }
   }
-
-  // считывание второй матрицы со стенами снизу
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      int temp = 0;
-      if (!(file >> temp)) {
-        file.close();
-        return Maze(0, 0);
-      }
-      // стена снизу записывается во второй бит ячейки,
-      // содержащей правую стену
-      maze.grid_[i][j] = maze.grid_[i][j] | (temp << 1);
-    }
-  }
-
-  file.close();
   return maze;
 }
 
-void MazeSerializer::saveToFile(Maze maze, const std::string file_path) {
-  std::ofstream file(file_path);
+void MazeSerializer::saveToFile(MazeGridView grid,
+                                const std::string file_path) {
+  std::ofstream file(file_path, std::ios::binary);
   if (!file) {
     std::cerr << "Cannot write to file:" + file_path << '\n';
     return;
   }
 
-  int rows = maze.getRows();
-  int cols = maze.getCols();
+  int rows = grid.rows();
+  int cols = grid.cols();
 
   if (rows < 1 || cols < 1) {
     file.close();
     return;
   }
 
-  file << rows << ' ' << cols << '\n';
+  // текст собирается в буфере и пишется крупными блоками
+  std::string buffer = std::to_string(rows) + ' ' + std::to_string(cols) + '\n';
+  buffer.reserve(WRITE_BUFFER_SIZE + 2 * static_cast<std::size_t>(cols) + 1);
+  // строка матрицы: цифра и разделитель на каждую ячейку
+  std::string line(2 * static_cast<std::size_t>(cols), ' ');
+  line.back() = '\n';
 
-  // запись в файл первой матрицы с правыми стенами
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      file << (maze.grid_[i][j] & Maze::Wall::RIGHT);
-      file << ((j == cols - 1) ? '\n' : ' ');
+  // первая матрица - правые стены, вторая - нижние
+  for (int plane = 0; plane < 2; plane++) {
+    if (plane == 1) buffer += '\n';
+    for (int i = 0; i < rows; i++) {
+      const std::uint64_t *words =
+          plane == 0 ? grid.rightRow(i) : grid.downRow(i);
+      for (int j = 0; j < cols; j++) {
+        std::uint64_t word = words[j / MazeGrid::WORD_BITS];
+        line[2 * j] = '0' + ((word >> (j % MazeGrid::WORD_BITS)) & 1);
+      }
+      buffer += line;
+      if (buffer.size() >= WRITE_BUFFER_SIZE) {
+        file.write(buffer.data(), buffer.size());
+        buffer.clear();
+      }
     }
   }
+  file.write(buffer.data(), buffer.size());
+  file.close();
+}
+
+Maze MazeSerializer::readFromBinaryFile(const std::string file_path,
+                                        bool verify) {
+  MazeFileHeader header;
+  if (!readBinaryHeader(file_path, header)) return Maze(0, 0);
+  if (header.block_rows != 0) return readFromCompressedFile(file_path);
+
+  std::uint64_t *words = nullptr;
+  std::shared_ptr<void> storage;
+#ifdef _WIN32
+  // без отображения в память плоскости читаются в собственный буфер
+  auto buffer = std::make_shared<std::vector<std::uint64_t>>(
+      header.payload_size / sizeof(std::uint64_t));
+  std::ifstream file(file_path, std::ios::binary);
+  file.seekg(header.header_size);
+  if (!file.read(reinterpret_cast<char *>(buffer->data()),
+                 header.payload_size)) {
+    std::cerr << "Cannot read file: " + file_path << '\n';
+    return Maze(0, 0);
+  }
+  words = buffer->data();
+  storage = buffer;
+#else
+  int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Cannot open file: " + file_path << '\n';
+    return Maze(0, 0);
+  }
+  // закрытое отображение: изменения стен копируют страницы, а не пишут в файл
+  std::size_t length = header.header_size + header.payload_size;
+  void *map = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    std::cerr << "Cannot map file: " + file_path << '\n';
+    return Maze(0, 0);
+  }
+  storage.reset(map, [length](void *address) { munmap(address, length); });
+  words = reinterpret_cast<std::uint64_t *>(static_cast<char *>(map) +
+                                            header.header_size);
+#endif
+
+  MazeGrid grid(header.rows, header.cols, words, std::move(storage));
+  if (verify && checksum(grid) != header.checksum) {
+    std::cerr << "Checksum mismatch: " + file_path << '\n';
+    return Maze(0, 0);
+  }
+  return Maze(std::move(grid));
+}
+
+void MazeSerializer::saveToBinaryFile(MazeGridView grid,
+                                      const std::string file_path,
+                                      std::optional<std::uint64_t> seed) {
+  if (grid.empty() || !isLittleEndianHost(file_path)) return;
+  std::ofstream file(file_path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot write to file:" + file_path << '\n';
+    return;
+  }
+
+  MazeFileHeader header = {};
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+  header.version = BINARY_VERSION;
+  header.header_size = sizeof(MazeFileHeader);
+  header.rows = grid.rows();
+  header.cols = grid.cols();
+  header.words_per_row = grid.wordsPerRow();
+  header.flags = seed ? FLAG_HAS_SEED : 0;
+  header.seed = seed.value_or(0);
+  header.payload_size = 2 * static_cast<std::uint64_t>(grid.rows()) *
+                        grid.wordsPerRow() * sizeof(std::uint64_t);
+  header.checksum = checksum(grid);
+
+  // плоскости всех строк лежат в представлении одним блоком
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(grid.rightRow(0)),
+             header.payload_size);
+  file.close();
+}
+
+bool MazeSerializer::readBinaryHeader(const std::string file_path,
+                                      MazeFileHeader &header) {
+  if (!isLittleEndianHost(file_path)) return false;
+  std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    std::cerr << "Cannot open file: " + file_path << '\n';
+    return false;
+  }
+  std::uint64_t file_size = file.tellg();
+  file.seekg(0);
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      (std::memcmp(header.magic, BINARY_MAGIC, sizeof(header.magic)) != 0 &&
+       std::memcmp(header.magic, COMPRESSED_MAGIC, sizeof(header.magic)) !=
+           0)) {
+    std::cerr << "Not a binary maze file: " + file_path << '\n';
+    return false;
+  }
+  if (header.version != BINARY_VERSION) {
+    std::cerr << "Unsupported maze file version: " +
+                     std::to_string(header.version)
+              << '\n';
+    return false;
+  }
+
+  // размеры должны соответствовать раскладке MazeGrid и размеру файла
+  bool compressed =
+      std::memcmp(header.magic, COMPRESSED_MAGIC, sizeof(header.magic)) == 0;
+  std::uint64_t words_per_row =
+      (static_cast<std::uint64_t>(header.cols) + MazeGrid::WORD_BITS - 1) /
+      MazeGrid::WORD_BITS;
+  std::uint64_t payload_size = 2 * static_cast<std::uint64_t>(header.rows) *
+                               words_per_row * sizeof(std::uint64_t);
+  if (compressed && header.block_rows > 0) {
+    // в сжатом файле данные - как минимум таблица смещений блоков
+    std::uint64_t blocks =
+        (header.rows + static_cast<std::uint64_t>(header.block_rows) - 1) /
+        header.block_rows;
+    std::uint64_t index_size = (blocks + 1) * sizeof(std::uint64_t);
+    payload_size = std::max(header.payload_size, index_size);
+  }
+  if (header.header_size != sizeof(MazeFileHeader) || header.rows <= 0 ||
+      header.cols <= 0 ||
+      static_cast<std::int64_t>(header.rows) * header.cols >
+          MazeGrid::MAX_CELLS ||
+      static_cast<std::uint64_t>(header.words_per_row) != words_per_row ||
+      (compressed ? header.block_rows <= 0 : header.block_rows != 0) ||
+      header.payload_size != payload_size ||
+      file_size < header.header_size + payload_size) {
+    std::cerr << "Corrupted maze file: " + file_path << '\n';
+    return false;
+  }
+  return true;
+}
+
+void MazeSerializer::saveToCompressedFile(MazeGridView grid,
+                                          const std::string file_path,
+                                          std::optional<std::uint64_t> seed,
+                                          int block_rows) {
+  if (grid.empty() || block_rows < 1) return;
+  MazeCompressedWriter writer(file_path, grid.rows(), grid.cols(), seed,
+                              block_rows);
+  for (int row = 0; row < grid.rows(); row++) {
+    MazeGridView line(1, grid.cols(), grid.wordsPerRow(), grid.rightRow(row));
+    if (!writer.append(row, line)) return;
+  }
+  writer.finish();
+}
+
+Maze MazeSerializer::readFromCompressedFile(const std::string file_path) {
+  MazeFileHeader header;
+  if (!readBinaryHeader(file_path, header) || header.block_rows == 0)
+    return Maze(0, 0);
+
+  Maze maze(header.rows, header.cols);
+  bool complete = readCompressedRows(
+      file_path, 0, header.rows, [&maze](int row, MazeGridView line) {
+        maze.grid_.copyRow(line, 0, row);
+        return true;
+      });
+  if (!complete) return Maze(0, 0);
+  if (checksum(maze.grid()) != header.checksum) {
+    std::cerr << "Checksum mismatch: " + file_path << '\n';
+    return Maze(0, 0);
+  }
+  return maze;
+}
+
+bool MazeSerializer::readCompressedRows(const std::string file_path,
+                                        int first_row, int count,
+                                        const MazeRowSink &sink) {
+  MazeFileHeader header;
+  if (!readBinaryHeader(file_path, header) || header.block_rows == 0)
+    return false;
+  if (first_row < 0 || count < 0 || first_row + count > header.rows)
+    return false;
+  if (count == 0) return true;
+
+  std::ifstream file(file_path, std::ios::binary);
+  int blocks = (header.rows + header.block_rows - 1) / header.block_rows;
+  std::vector<std::uint64_t> offsets(blocks + 1);
+  file.seekg(sizeof(MazeFileHeader));
+  file.read(reinterpret_cast<char *>(offsets.data()),
+            offsets.size() * sizeof(std::uint64_t));
+  std::uint64_t file_end = header.header_size + header.payload_size;
+  if (!file || offsets.back() != file_end ||
+      !std::is_sorted(offsets.begin(), offsets.end())) {
+    std::cerr << "Corrupted maze file: " + file_path << '\n';
+    return false;
+  }
 
-  file << '\n';
+  // в памяти находится только текущий блок
+  std::vector<std::uint8_t> data;
+  int last_row = first_row + count - 1;
+  for (int block = first_row / header.block_rows;
+       block <= last_row / header.block_rows; block++) {
+    int block_first = block * header.block_rows;
+    int block_count = std::min(header.block_rows, header.rows - block_first);
+    data.resize(offsets[block + 1] - offsets[block]);
+    file.seekg(offsets[block]);
+    if (!file.read(reinterpret_cast<char *>(data.data()), data.size())) {
+      std::cerr << "Cannot read file: " + file_path << '\n';
+      return false;
+    }
+    // за сжатыми строками блока лежит их контрольная сумма, если она есть
+    bool has_checksum = header.flags & FLAG_BLOCK_CHECKSUMS;
+    std::size_t size = data.size();
+    std::uint64_t block_checksum = 0;
+    bool valid = !has_checksum || size >= sizeof(block_checksum);
+    if (valid && has_checksum) {
+      size -= sizeof(block_checksum);
+      std::memcpy(&block_checksum, data.data() + size, sizeof(block_checksum));
+    }
+    MazeGrid rows(block_count, header.cols);
+    valid = valid && MazeCodec::decodeRows(data.data(), size, block_first,
+                                           header.rows, rows);
+    if (!valid || (has_checksum && checksum(rows) != block_checksum)) {
+      std::cerr << "Corrupted maze file block " + std::to_string(block) +
+                       ": " + file_path
+                << '\n';
+      return false;
+    }
 
-  // запись в файл второй матрицы со стенами снизу
-  for (int i = 0; i < rows; i++) {
-    for (int j = 0; j < cols; j++) {
-      file << ((maze.grid_[i][j] & Maze::Wall::DOWN) >> 1);
-      file << ((j == cols - 1) ? '\n' : ' ');
+    int from = std::max(first_row, block_first);
+    int to = std::min(last_row, block_first + block_count - 1);
+    for (int row = from; row <= to; row++) {
+      MazeGridView line(1, rows.cols(), rows.wordsPerRow(),
+                        rows.rightRow(row - block_first));
+      if (!sink(row, line)) return false;
     }
   }
+  return true;
+}
 
+void MazeSerializer::saveDescriptor(const MazeDescriptor &descriptor,
+                                    const std::string file_path) {
+  if (!isLittleEndianHost(file_path)) return;
+  std::ofstream file(file_path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot write to file:" + file_path << '\n';
+    return;
+  }
+  file.write(DESCRIPTOR_MAGIC, sizeof(DESCRIPTOR_MAGIC));
+  file.write(reinterpret_cast<const char *>(&descriptor), sizeof(descriptor));
   file.close();
 }
+
+bool MazeSerializer::readDescriptor(const std::string file_path,
+                                    MazeDescriptor &descriptor) {
+  if (!isLittleEndianHost(file_path)) return false;
+  std::ifstream file(file_path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot open file: " + file_path << '\n';
+    return false;
+  }
+  char magic[sizeof(DESCRIPTOR_MAGIC)] = {};
+  if (!file.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, DESCRIPTOR_MAGIC, sizeof(magic)) != 0 ||
+      !file.read(reinterpret_cast<char *>(&descriptor), sizeof(descriptor))) {
+    std::cerr << "Not a maze descriptor file: " + file_path << '\n';
+    return false;
+  }
+  // лабиринт другой версии генераторов не совпал бы с сохраненным
+  if (!MazeBuilder::isValid(descriptor)) {
+    std::cerr << "Unsupported maze descriptor: " + file_path << '\n';
+    return false;
+  }
+  return true;
+}
+
+Maze MazeSerializer::readFromDescriptorFile(const std::string file_path) {
+  MazeDescriptor descriptor;
+  if (!readDescriptor(file_path, descriptor)) return Maze(0, 0);
+  MazeBuilder builder(0);
+  return builder.createMaze(descriptor);
+}
+
+bool MazeSerializer::readDescriptorRows(const std::string file_path,
+                                        int first_row, int count,
+                                        const MazeRowSink &sink) {
+  MazeDescriptor descriptor;
+  if (!readDescriptor(file_path, descriptor)) return false;
+  MazeBuilder builder(0);
+  return builder.generate(descriptor, first_row, count, sink);
+}
+
+bool MazeSerializer::isLittleEndianHost(const std::string &file_path) {
+  if constexpr (std::endian::native == std::endian::little) return true;
+  std::cerr << "Binary maze files need a little-endian host: " + file_path
+            << '\n';
+  return false;
+}
+
+std::uint64_t MazeSerializer::checksum(MazeGridView grid,
+                                       std::uint64_t hash) {
+  std::size_t words = 2 * static_cast<std::size_t>(grid.rows()) *
+                      grid.wordsPerRow();
+  const std::uint64_t *data = grid.rightRow(0);
+  for (std::size_t i = 0; i < words; i++) {
+    hash = (hash ^ data[i]) * 0x100000001b3;
+    hash ^= hash >> 32;
+  }
+  return hash;
+}
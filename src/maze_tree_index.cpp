@@ -0,0 +1,159 @@
+#include "../include/maze_tree_index.h"
+
+#include <algorithm>
+#include <bit>
+
+MazeTreeIndex::MazeTreeIndex() : cols_(0) {}
+
+MazeTreeIndex::MazeTreeIndex(MazeGridView grid) : MazeTreeIndex() {
+  build(grid);
+}
+
+bool MazeTreeIndex::build(MazeGridView grid) {
+  clear();
+  if (grid.empty()) return false;
+
+  int rows = grid.rows();
+  int cols = grid.cols();
+  int cells = rows * cols;
+
+  // в дереве ровно cells - 1 ребро, считаем проходы между ячейками
+  long long edges = 0;
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      if (j != cols - 1 && !grid.hasRightWall(i, j)) edges++;
+      if (i != rows - 1 && !grid.hasDownWall(i, j)) edges++;
+    }
+  }
+  if (edges != cells - 1) return false;
+
+  cols_ = cols;
+  parent_.assign(cells, -1);
+  depth_.assign(cells, -1);
+  first_.assign(cells, 0);
+  euler_.reserve(2 * static_cast<std::size_t>(cells) - 1);
+
+  // итеративный обход в глубину от корня: в стеке ячейка и номер следующего
+  // соседа для проверки
+  std::vector<std::pair<int, int>> stack;
+  stack.push_back({0, 0});
+  depth_[0] = 0;
+  first_[0] = 0;
+  euler_.push_back(0);
+
+  while (!stack.empty()) {
+    auto &[current, next] = stack.back();
+    int neighbors[4];
+    int count = grid.neighbors(current / cols_, current % cols_, neighbors);
+    while (next < count && neighbors[next] == parent_[current]) next++;
+
+    if (next < count) {
+      int child = neighbors[next++];
+      // повторное посещение означает петлю - лабиринт не идеальный
+      if (depth_[child] != -1) {
+        clear();
+        return false;
+      }
+      parent_[child] = current;
+      depth_[child] = depth_[current] + 1;
+      first_[child] = static_cast<int>(euler_.size());
+      euler_.push_back(child);
+      stack.push_back({child, 0});
+    } else {
+      stack.pop_back();
+      if (!stack.empty()) euler_.push_back(stack.back().first);
+    }
+  }
+
+  // не все ячейки достижимы из корня
+  if (static_cast<int>(euler_.size()) != 2 * cells - 1) {
+    clear();
+    return false;
+  }
+
+  buildSparseTable();
+  return true;
+}
+
+void MazeTreeIndex::buildSparseTable() {
+  int blocks = (static_cast<int>(euler_.size()) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+  // уровень 0 - минимум по глубине внутри каждого блока
+  sparse_.assign(1, std::vector<int>(blocks));
+  for (int b = 0; b < blocks; b++) {
+    int begin = b * BLOCK_SIZE;
+    int end = std::min(begin + BLOCK_SIZE, static_cast<int>(euler_.size()));
+    int best = euler_[begin];
+    for (int i = begin + 1; i < end; i++) best = shallower(best, euler_[i]);
+    sparse_[0][b] = best;
+  }
+
+  for (int k = 1; (1 << k) <= blocks; k++) {
+    const std::vector<int> &prev = sparse_[k - 1];
+    std::vector<int> level(blocks - (1 << k) + 1);
+    for (size_t b = 0; b < level.size(); b++) {
+      level[b] = shallower(prev[b], prev[b + (1 << (k - 1))]);
+    }
+    sparse_.push_back(std::move(level));
+  }
+}
+
+int MazeTreeIndex::lca(int from, int to) const {
+  int left = std::min(first_[from], first_[to]);
+  int right = std::max(first_[from], first_[to]);
+  int left_block = left / BLOCK_SIZE;
+  int right_block = right / BLOCK_SIZE;
+
+  int best = euler_[left];
+  if (left_block == right_block) {
+    for (int i = left + 1; i <= right; i++) best = shallower(best, euler_[i]);
+    return best;
+  }
+
+  // хвост левого и начало правого блока просматриваются напрямую
+  for (int i = left + 1; i < (left_block + 1) * BLOCK_SIZE; i++)
+    best = shallower(best, euler_[i]);
+  for (int i = right_block * BLOCK_SIZE; i <= right; i++)
+    best = shallower(best, euler_[i]);
+
+  // целые блоки между ними - запросом к разреженной таблице
+  int count = right_block - left_block - 1;
+  if (count > 0) {
+    int k = std::bit_width(static_cast<unsigned>(count)) - 1;
+    best = shallower(best, sparse_[k][left_block + 1]);
+    best = shallower(best, sparse_[k][right_block - (1 << k)]);
+  }
+  return best;
+}
+
+int MazeTreeIndex::pathLength(int from, int to) const {
+  if (!isValid()) return -1;
+  return depth_[from] + depth_[to] - 2 * depth_[lca(from, to)];
+}
+
+std::vector<std::pair<int, int>> MazeTreeIndex::path(int from, int to) const {
+  std::vector<std::pair<int, int>> result;
+  if (!isValid()) return result;
+
+  int ancestor = lca(from, to);
+  // поднимаемся от старта до общего предка
+  for (int id = from; id != ancestor; id = parent_[id])
+    result.push_back(std::make_pair(id / cols_, id % cols_));
+  result.push_back(std::make_pair(ancestor / cols_, ancestor % cols_));
+
+  // спуск от предка к финишу - это подъем от финиша в обратном порядке
+  size_t middle = result.size();
+  for (int id = to; id != ancestor; id = parent_[id])
+    result.push_back(std::make_pair(id / cols_, id % cols_));
+  std::reverse(result.begin() + middle, result.end());
+  return result;
+}
+
+void MazeTreeIndex::clear() {
+  cols_ = 0;
+  parent_.clear();
+  depth_.clear();
+  first_.clear();
+  euler_.clear();
+  sparse_.clear();
+}
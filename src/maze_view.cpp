@@ -1,6 +1,168 @@
 #include <maze_view.h>
 
-MazeView::MazeView(QWidget *parent) : QGraphicsView(parent) {
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief Подсчитывает единичные биты строки в столбцах [from, to)
+ * @param[in] words слова строки одной плоскости стен
+ * @param[in] from первый столбец
+ * @param[in] to столбец за последним
+ * @return Количество единичных битов
+ */
+int countBits(const std::uint64_t *words, int from, int to) {
+  int count = 0;
+  int last = to - 1;
+  for (int w = from / MazeGrid::WORD_BITS; w <= last / MazeGrid::WORD_BITS;
+       w++) {
+    std::uint64_t mask = ~std::uint64_t{0};
+    if (w == from / MazeGrid::WORD_BITS) mask <<= from % MazeGrid::WORD_BITS;
+    if (w == last / MazeGrid::WORD_BITS)
+      mask &= ~std::uint64_t{0} >> (63 - last % MazeGrid::WORD_BITS);
+    count += std::popcount(words[w] & mask);
+  }
+  return count;
+}
+
+/**
+ * @brief Добавляет отрезки стен прямоугольника ячеек. Стены соседних ячеек
+ * на одной линии сливаются в один отрезок.
+ * @param[in] grid стены лабиринта
+ * @param[in] cells прямоугольник ячеек: x - столбцы, y - строки
+ * @param[in] size размер ячейки в пикселях
+ * @param[in] origin положение левого верхнего угла лабиринта в пикселях
+ * @param[out] lines отрезки стен
+ */
+void appendWallRuns(MazeGridView grid, QRect cells, double size,
+                    QPointF origin, QVector<QLineF> &lines) {
+  auto x = [&](int col) { return origin.x() + col * size; };
+  auto y = [&](int row) { return origin.y() + row * size; };
+  int col0 = cells.left(), col1 = cells.left() + cells.width();
+  int row0 = cells.top(), row1 = cells.top() + cells.height();
+
+  // внешние стены сверху и слева
+  if (row0 == 0) lines.append(QLineF(x(col0), y(0), x(col1), y(0)));
+  if (col0 == 0) lines.append(QLineF(x(0), y(row0), x(0), y(row1)));
+
+  // начало незакрытого вертикального отрезка в каждом столбце, -1 - нет
+  std::vector<int> run_start(cells.width(), -1);
+  for (int i = row0; i < row1; ++i) {
+    int start = -1;
+    for (int j = col0; j < col1; ++j) {
+      // стены снизу соседних ячеек сливаются в горизонтальный отрезок
+      if (grid.hasDownWall(i, j)) {
+        if (start < 0) start = j;
+      } else if (start >= 0) {
+        lines.append(QLineF(x(start), y(i + 1), x(j), y(i + 1)));
+        start = -1;
+      }
+      // стены справа ячеек одного столбца - в вертикальный
+      int &run = run_start[j - col0];
+      if (grid.hasRightWall(i, j)) {
+        if (run < 0) run = i;
+      } else if (run >= 0) {
+        lines.append(QLineF(x(j + 1), y(run), x(j + 1), y(i)));
+        run = -1;
+      }
+    }
+    if (start >= 0)
+      lines.append(QLineF(x(start), y(i + 1), x(col1), y(i + 1)));
+  }
+  for (int j = col0; j < col1; ++j) {
+    int run = run_start[j - col0];
+    if (run >= 0) lines.append(QLineF(x(j + 1), y(run), x(j + 1), y(row1)));
+  }
+}
+
+/**
+ * @brief Отрисовывает область лабиринта в изображение. Выполняется в
+ * фоновом потоке, поэтому использует только свои аргументы.
+ * @param[in] grid стены лабиринта
+ * @param[in] scale размер ячейки в пикселях
+ * @param[in] area область в пикселях от левого верхнего угла лабиринта
+ * @param[in] ratio отношение физических пикселей экрана к логическим
+ * @param[in] color цвет стен
+ * @param[in] lines true - стены рисуются линиями, false - обзор: яркость
+ * пикселя пропорциональна доле стен в покрытом им блоке ячеек
+ * @param[in] thickness наибольшая толщина стен в пикселях
+ * @return Изображение области
+ */
+QImage renderArea(MazeGridView grid, double scale, QRect area, qreal ratio,
+                  QColor color, bool lines, double thickness) {
+  QImage image((QSizeF(area.size()) * ratio).toSize(),
+               QImage::Format_ARGB32_Premultiplied);
+  image.fill(Qt::transparent);
+
+  if (lines) {
+    image.setDevicePixelRatio(ratio);
+    // ячейки области с запасом в одну ячейку с каждой стороны: толстые
+    // стены соседних ячеек заходят на область
+    int col0 = std::max(0, static_cast<int>(std::floor(area.x() / scale)) - 1);
+    int row0 = std::max(0, static_cast<int>(std::floor(area.y() / scale)) - 1);
+    int col1 = std::min(
+        grid.cols(),
+        static_cast<int>(std::ceil((area.x() + area.width()) / scale)) + 1);
+    int row1 = std::min(
+        grid.rows(),
+        static_cast<int>(std::ceil((area.y() + area.height()) / scale)) + 1);
+    if (col0 >= col1 || row0 >= row1) return image;
+
+    QVector<QLineF> walls;
+    appendWallRuns(grid, QRect(col0, row0, col1 - col0, row1 - row0), scale,
+                   -QPointF(area.topLeft()), walls);
+    QPainter painter(&image);
+    painter.setPen(QPen(color, std::clamp(scale / 4, 1.0, thickness),
+                        Qt::SolidLine, Qt::FlatCap));
+    painter.drawLines(walls);
+    return image;
+  }
+
+  // обзор считается в физических пикселях
+  double pixel_scale = scale * ratio;
+  auto cellRange = [pixel_scale](double pixel, int count, int &from, int &to) {
+    from = static_cast<int>(std::floor(pixel / pixel_scale));
+    to = static_cast<int>(std::floor((pixel + 1) / pixel_scale));
+    to = std::min(std::max(to, from + 1), count);
+    return from >= 0 && from < count;
+  };
+  for (int py = 0; py < image.height(); py++) {
+    int row0, row1;
+    if (!cellRange(area.y() * ratio + py, grid.rows(), row0, row1)) continue;
+    QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(py));
+    for (int px = 0; px < image.width(); px++) {
+      int col0, col1;
+      if (!cellRange(area.x() * ratio + px, grid.cols(), col0, col1)) continue;
+      int walls = 0;
+      for (int row = row0; row < row1; row++) {
+        walls += countBits(grid.rightRow(row), col0, col1) +
+                 countBits(grid.downRow(row), col0, col1);
+      }
+      double density = walls / (2.0 * (row1 - row0) * (col1 - col0));
+      line[px] = qPremultiply(qRgba(color.red(), color.green(), color.blue(),
+                                    qRound(255 * density)));
+    }
+  }
+  return image;
+}
+
+}  // namespace
+
+MazeView::MazeView(QWidget *parent)
+    : QGraphicsView(parent),
+      cell_size_(0),
+      offset_x_(0),
+      offset_y_(0),
+      fitted_(true),
+      panning_(false),
+      solution_item_(nullptr),
+      level_(std::numeric_limits<int>::min()),
+      generation_(0),
+      overview_scale_(0),
+      overview_pending_(false) {
   scene_ = new QGraphicsScene(this);
   setScene(scene_);
   setRenderHint(QPainter::Antialiasing);
@@ -9,139 +171,365 @@ MazeView::MazeView(QWidget *parent) : QGraphicsView(parent) {
   setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
   setFrameShape(QFrame::NoFrame);
+
+  for (QString type : {"start", "finish"})
+    icon_sources_.insert(type, QPixmap(":/icons/" + type + "_icon.png"));
+  tiles_.setMaxCost(TILE_CACHE_KB);
+}
+
+MazeView::~MazeView() {
+  pool_.clear();
+  pool_.waitForDone();
 }
 
 void MazeView::mousePressEvent(QMouseEvent *event) {
-  QPointF scene_pos = mapToScene(event->pos());
-  // поиск ячейки на сцене по координатам клика
-  QGraphicsItem *item = scene()->itemAt(scene_pos, QTransform());
-
-  if (item) {
-    QGraphicsRectItem *rect = qgraphicsitem_cast<QGraphicsRectItem *>(item);
-    if (rect) {
-      if (item->data(Cell::PRESSED).toBool() == false &&
-          selected_points_.size() < 2) {
-        if (!selected_points_.contains("start")) {
-          setPoint("start", rect);
-        } else if (!selected_points_.contains("finish")) {
-          setPoint("finish", rect);
-        }
-      } else {
-        if (*(selected_points_.find("start")) == rect) {
-          removePoint("start", rect);
-        } else if (*(selected_points_.find("finish")) == rect) {
-          removePoint("finish", rect);
-        }
-      }
-      sendSelectedPoints();
+  if (event->button() == Qt::RightButton ||
+      event->button() == Qt::MiddleButton) {
+    panning_ = true;
+    pan_pos_ = event->pos();
+    return;
+  }
+
+  // ячейка под курсором вычисляется по размеру ячейки и отступам
+  Cell cell;
+  if (event->button() == Qt::LeftButton && cellAt(event->pos(), cell)) {
+    QString type = selected_points_.key(cell);
+    if (!type.isEmpty()) {
+      removePoint(type);
+    } else if (!selected_points_.contains("start")) {
+      setPoint("start", cell);
+    } else if (!selected_points_.contains("finish")) {
+      setPoint("finish", cell);
     }
+    sendSelectedPoints();
   }
   update();
   QGraphicsView::mousePressEvent(event);
 }
 
-void MazeView::setMaze(std::vector<std::vector<int>> grid) {
+void MazeView::mouseMoveEvent(QMouseEvent *event) {
+  if (!panning_) {
+    QGraphicsView::mouseMoveEvent(event);
+    return;
+  }
+  QPointF pos = event->pos();
+  offset_x_ += pos.x() - pan_pos_.x();
+  offset_y_ += pos.y() - pan_pos_.y();
+  pan_pos_ = pos;
+  clampOffsets();
+  updateView();
+}
+
+void MazeView::mouseReleaseEvent(QMouseEvent *event) {
+  if (!(event->buttons() & (Qt::RightButton | Qt::MiddleButton)))
+    panning_ = false;
+  QGraphicsView::mouseReleaseEvent(event);
+}
+
+void MazeView::wheelEvent(QWheelEvent *event) {
+  event->accept();
+  if (maze_grid_.empty()) return;
+
+  // один шаг колеса - четверть удвоения, как уровни плиток
+  double steps = event->angleDelta().y() / 120.0;
+  double fit = fitCellSize();
+  double size = cell_size_ * std::exp2(steps / LEVELS_PER_OCTAVE);
+  size = std::max(fit, std::min(size, std::max(MAX_CELL_SIZE, fit)));
+  if (size <= fit) {
+    fitToView();
+  } else {
+    // точка лабиринта под курсором остается на месте
+    QPointF pos = event->position();
+    offset_x_ = pos.x() - (pos.x() - offset_x_) * size / cell_size_;
+    offset_y_ = pos.y() - (pos.y() - offset_y_) * size / cell_size_;
+    cell_size_ = size;
+    fitted_ = false;
+    clampOffsets();
+  }
+  updateView();
+}
+
+void MazeView::setMaze(MazeGridView grid) {
   clearScene();
   maze_grid_ = grid;
+  fitToView();
+  updateView();
+}
 
-  int rows = maze_grid_.size();
-  int cols = maze_grid_[0].size();
-
+void MazeView::resizeEvent(QResizeEvent *event) {
+  QGraphicsView::resizeEvent(event);
   // установка размеров сцены равными размеру виджета
   scene_->setSceneRect(0, 0, rect().width(), rect().height());
+  if (maze_grid_.empty()) return;
+  if (fitted_)
+    fitToView();
+  else
+    clampOffsets();
+  updateView();
+}
 
-  double cell_width = rect().width() / static_cast<double>(cols);
-  double cell_height = rect().height() / static_cast<double>(rows);
+double MazeView::fitCellSize() const {
+  if (maze_grid_.empty()) return 0;
+  double cell_width = rect().width() / static_cast<double>(maze_grid_.cols());
+  double cell_height = rect().height() / static_cast<double>(maze_grid_.rows());
   // расчет размера ячейки с учетом сохранения квадратной формы
-  cell_size_ = std::min(cell_width, cell_height);
-  // вычисление отступов для центированной отрисовки
-  double offset_x = (rect().width() - (cell_size_ * cols)) / 2.0;
-  double offset_y = (rect().height() - (cell_size_ * rows)) / 2.0;
-
-  for (int i = 0; i < rows; ++i) {
-    for (int j = 0; j < cols; ++j) {
-      double x = offset_x + j * cell_size_;
-      double y = offset_y + i * cell_size_;
-
-      // создание ячейки и сохранение её данных
-      QGraphicsRectItem *cell =
-          scene_->addRect(x, y, cell_size_, cell_size_, QPen(Qt::NoPen));
-      cell->setData(Cell::ROW, i);
-      cell->setData(Cell::COL, j);
-      cell->setData(Cell::PRESSED, false);
-    }
+  return std::min(cell_width, cell_height);
+}
+
+void MazeView::fitToView() {
+  cell_size_ = fitCellSize();
+  fitted_ = true;
+  clampOffsets();
+}
+
+void MazeView::clampOffsets() {
+  double width = maze_grid_.cols() * cell_size_;
+  double height = maze_grid_.rows() * cell_size_;
+  // меньший виджета лабиринт центрируется, больший не отходит от краев
+  if (width <= rect().width())
+    offset_x_ = (rect().width() - width) / 2.0;
+  else
+    offset_x_ = std::clamp(offset_x_, rect().width() - width, 0.0);
+  if (height <= rect().height())
+    offset_y_ = (rect().height() - height) / 2.0;
+  else
+    offset_y_ = std::clamp(offset_y_, rect().height() - height, 0.0);
+}
+
+void MazeView::updateView() {
+  // ломаная решения задана в координатах ячеек и только переносится
+  if (solution_item_) {
+    solution_item_->setTransform(
+        QTransform(cell_size_, 0, 0, cell_size_, offset_x_, offset_y_));
   }
+  scaleIcons();
+  update();
+}
+
+void MazeView::scaleIcons() {
+  double side = std::max(cell_size_, MIN_ICON_SIZE);
+  QSize size = QSizeF(side, side).toSize();
+  if (!icons_.isEmpty() && icons_.first().size() == size) return;
+  for (auto iter = icon_sources_.begin(); iter != icon_sources_.end(); iter++) {
+    icons_.insert(iter.key(), iter.value().scaled(size, Qt::KeepAspectRatio,
+                                                  Qt::SmoothTransformation));
+  }
+}
+
+QRectF MazeView::cellRect(Cell cell) const {
+  return QRectF(offset_x_ + cell.second * cell_size_,
+                offset_y_ + cell.first * cell_size_, cell_size_, cell_size_);
+}
+
+bool MazeView::cellAt(QPointF pos, Cell &cell) const {
+  if (maze_grid_.empty() || cell_size_ <= 0) return false;
+  double x = (pos.x() - offset_x_) / cell_size_;
+  double y = (pos.y() - offset_y_) / cell_size_;
+  if (x < 0 || y < 0) return false;
+  cell = {static_cast<int>(y), static_cast<int>(x)};
+  return cell.first < maze_grid_.rows() && cell.second < maze_grid_.cols();
 }
 
 void MazeView::clearScene() {
+  // фоновая отрисовка читает стены, поэтому она останавливается до того,
+  // как лабиринт будет изменен
+  generation_++;
+  pool_.clear();
+  pool_.waitForDone();
+  tiles_.clear();
+  pending_.clear();
+  overview_ = QPixmap();
+  overview_pending_ = false;
+  level_ = std::numeric_limits<int>::min();
+
   selected_points_.clear();
   clearMazeSolution();
   scene_->clear();
-  maze_grid_.clear();
+  maze_grid_ = MazeGridView();
+  fitted_ = true;
+  panning_ = false;
 }
 
 void MazeView::paintEvent(QPaintEvent *event) {
   QGraphicsView::paintEvent(event);
 
-  if (maze_grid_.empty()) return;
+  // до раскладки и у скрытого виджета размер ячейки нулевой
+  if (maze_grid_.empty() || cell_size_ <= 0) return;
 
+  // стены берутся из готовых плиток, перерисовка - только их копирование
   QPainter painter(viewport());
+  paintTiles(painter);
 
-  int rows = maze_grid_.size();
-  int cols = maze_grid_[0].size();
-
-  double offset_x = (rect().width() - (cell_size_ * cols)) / 2.0;
-  double offset_y = (rect().height() - (cell_size_ * rows)) / 2.0;
-
-  QPen wall_pen(color_map[Color::WALL_COLOR], WALL_THICKNESS, Qt::SolidLine,
-                Qt::FlatCap);
-  painter.setPen(wall_pen);
-
-  for (int i = 0; i < rows; ++i) {
-    for (int j = 0; j < cols; ++j) {
-      double x = offset_x + j * cell_size_;
-      double y = offset_y + i * cell_size_;
-      // отрисовка стены сверху ячейки
-      if (i == 0) painter.drawLine(QPointF(x, y), QPointF(x + cell_size_, y));
-      // отрисовка стены слева ячейки
-      if (j == 0) painter.drawLine(QPointF(x, y), QPointF(x, y + cell_size_));
-      // отрисовка стены справа ячейки
-      if ((maze_grid_[i][j] & Wall::RIGHT) == Wall::RIGHT) {
-        painter.drawLine(QPointF(x + cell_size_, y),
-                         QPointF(x + cell_size_, y + cell_size_));
-      }
-      // отрисовка стены снизу ячейки
-      if ((maze_grid_[i][j] & Wall::DOWN) == Wall::DOWN) {
-        painter.drawLine(QPointF(x, y + cell_size_),
-                         QPointF(x + cell_size_, y + cell_size_));
-      }
-    }
-  }
   // отрисовка иконок на точках старта и финиша
   for (auto iter = selected_points_.begin(); iter != selected_points_.end();
        iter++) {
-    QGraphicsRectItem *cell = iter.value();
-    QPixmap icon(":/icons/" + iter.key() + "_icon.png");
-    QRectF cell_rect = cell->sceneBoundingRect();
-    QPointF top_left = mapFromScene(cell_rect.topLeft());
-    QSize size = cell_rect.size().toSize();
-    painter.drawPixmap(top_left, icon.scaled(size, Qt::KeepAspectRatio,
-                                             Qt::SmoothTransformation));
+    const QPixmap &icon = icons_[iter.key()];
+    QPointF center = cellRect(iter.value()).center();
+    painter.drawPixmap(center - QPointF(icon.width(), icon.height()) / 2.0,
+                       icon);
+  }
+
+  if (!fitted_) paintOverview(painter);
+}
+
+void MazeView::paintTiles(QPainter &painter) {
+  if (cell_size_ <= 0) return;
+  // уровень плиток - ближайший не меньший размера ячейки, поэтому плитки
+  // только уменьшаются при отрисовке. сверху уровень ограничен наибольшим
+  // приближением (как в wheelEvent), снизу - DENSITY_OCTAVES удвоениями
+  // обзора плотности
+  int level = std::clamp(
+      levelFor(cell_size_),
+      levelFor(MIN_LINE_CELL_SIZE) - DENSITY_OCTAVES * LEVELS_PER_OCTAVE,
+      levelFor(std::max(MAX_CELL_SIZE, fitCellSize())));
+  if (level != level_) {
+    // заказы плиток прежнего уровня больше не нужны
+    pool_.clear();
+    pending_.clear();
+    if (overview_.isNull()) overview_pending_ = false;
+    level_ = level;
   }
+  if (overview_.isNull()) requestOverview();
+
+  double tile = TILE_SIZE * cell_size_ / levelScale(level);
+  QRectF maze_rect(offset_x_, offset_y_, maze_grid_.cols() * cell_size_,
+                   maze_grid_.rows() * cell_size_);
+  QRectF visible = maze_rect.adjusted(-WALL_THICKNESS, -WALL_THICKNESS,
+                                      WALL_THICKNESS, WALL_THICKNESS) &
+                   QRectF(rect());
+  if (visible.isEmpty()) return;
+
+  // номера видимых плиток
+  auto tileAt = [tile](double pos) {
+    return static_cast<int>(std::floor(pos / tile));
+  };
+  int tile_x0 = tileAt(visible.left() - offset_x_);
+  int tile_x1 = tileAt(visible.right() - offset_x_);
+  int tile_y0 = tileAt(visible.top() - offset_y_);
+  int tile_y1 = tileAt(visible.bottom() - offset_y_);
+
+  painter.setRenderHint(QPainter::SmoothPixmapTransform);
+  for (int tile_y = tile_y0; tile_y <= tile_y1; tile_y++) {
+    for (int tile_x = tile_x0; tile_x <= tile_x1; tile_x++) {
+      QRectF target(offset_x_ + tile_x * tile, offset_y_ + tile_y * tile, tile,
+                    tile);
+      QPixmap *pixmap = tiles_.object(tileKey(level, tile_x, tile_y));
+      if (pixmap) {
+        painter.drawPixmap(target, *pixmap, QRectF(pixmap->rect()));
+        continue;
+      }
+      requestTile(level, tile_x, tile_y);
+      // пока плитки нет, на её месте растягивается часть обзора
+      if (!overview_.isNull()) {
+        double ratio = overview_scale_ / cell_size_;
+        QRectF source((target.left() - offset_x_) * ratio,
+                      (target.top() - offset_y_) * ratio, tile * ratio,
+                      tile * ratio);
+        painter.drawPixmap(target, overview_, source);
+      }
+    }
+  }
+}
+
+void MazeView::paintOverview(QPainter &painter) {
+  if (overview_.isNull()) return;
+  QRectF frame(rect().width() - overview_.width() - OVERVIEW_MARGIN,
+               rect().height() - overview_.height() - OVERVIEW_MARGIN,
+               overview_.width(), overview_.height());
+  painter.fillRect(frame.adjusted(-2, -2, 2, 2), QColor(0, 0, 0, 160));
+  painter.drawPixmap(frame.topLeft(), overview_);
+
+  // рамка видимой части лабиринта
+  double ratio = overview_scale_ / cell_size_;
+  QRectF visible(-offset_x_ * ratio, -offset_y_ * ratio,
+                 rect().width() * ratio, rect().height() * ratio);
+  painter.setPen(QPen(color_map[Color::PATH_COLOR], 1));
+  painter.setBrush(Qt::NoBrush);
+  painter.drawRect(visible.translated(frame.topLeft()) & frame);
+}
+
+void MazeView::requestTile(int level, int tile_x, int tile_y) {
+  quint64 key = tileKey(level, tile_x, tile_y);
+  if (pending_.contains(key)) return;
+  pending_.insert(key);
+
+  MazeGridView grid = maze_grid_;
+  int generation = generation_;
+  double scale = levelScale(level);
+  qreal ratio = devicePixelRatioF();
+  QColor color = color_map[Color::WALL_COLOR];
+  QRect area(tile_x * TILE_SIZE, tile_y * TILE_SIZE, TILE_SIZE, TILE_SIZE);
+  pool_.start([this, grid, generation, key, scale, ratio, color, area]() {
+    QImage image = renderArea(grid, scale, area, ratio, color,
+                              scale >= MIN_LINE_CELL_SIZE, WALL_THICKNESS);
+    // готовая плитка передается в поток виджета
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, key, image]() {
+          if (generation != generation_) return;
+          pending_.remove(key);
+          tiles_.insert(key, new QPixmap(QPixmap::fromImage(image)),
+                        std::max<qsizetype>(image.sizeInBytes() / 1024, 1));
+          update();
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+void MazeView::requestOverview() {
+  if (overview_pending_ || maze_grid_.empty()) return;
+  overview_pending_ = true;
+
+  MazeGridView grid = maze_grid_;
+  int generation = generation_;
+  double scale = std::min(OVERVIEW_SIZE / static_cast<double>(grid.cols()),
+                          OVERVIEW_SIZE / static_cast<double>(grid.rows()));
+  QRect area(0, 0, static_cast<int>(std::ceil(grid.cols() * scale)),
+             static_cast<int>(std::ceil(grid.rows() * scale)));
+  QColor color = color_map[Color::WALL_COLOR];
+  pool_.start([this, grid, generation, scale, area, color]() {
+    QImage image = renderArea(grid, scale, area, 1.0, color,
+                              scale >= MIN_LINE_CELL_SIZE, WALL_THICKNESS);
+    QMetaObject::invokeMethod(
+        this,
+        [this, generation, scale, image]() {
+          if (generation != generation_) return;
+          overview_ = QPixmap::fromImage(image);
+          overview_scale_ = scale;
+          overview_pending_ = false;
+          update();
+        },
+        Qt::QueuedConnection);
+  });
+}
+
+int MazeView::levelFor(double cell_size) {
+  return static_cast<int>(
+      std::ceil(LEVELS_PER_OCTAVE * std::log2(cell_size) - 1e-9));
+}
+
+double MazeView::levelScale(int level) {
+  return std::exp2(static_cast<double>(level) / LEVELS_PER_OCTAVE);
+}
+
+quint64 MazeView::tileKey(int level, int tile_x, int tile_y) {
+  // номера плиток сдвигаются на одну, чтобы плитки рамки у левого и
+  // верхнего края лабиринта получили неотрицательные номера
+  return (static_cast<quint64>(static_cast<quint16>(level)) << 48) |
+         (static_cast<quint64>((tile_y + 1) & 0xFFFFFF) << 24) |
+         static_cast<quint64>((tile_x + 1) & 0xFFFFFF);
 }
 
 void MazeView::sendSelectedPoints() {
   if (selected_points_.contains("start")) {
-    QGraphicsItem *item = selected_points_["start"];
-    emit startUpdated(item->data(Cell::ROW).toInt(),
-                      item->data(Cell::COL).toInt());
+    Cell cell = selected_points_["start"];
+    emit startUpdated(cell.first, cell.second);
   } else
     emit startUpdated(0, 0);
 
   if (selected_points_.contains("finish")) {
-    QGraphicsItem *item = selected_points_["finish"];
-    emit finishUpdated(item->data(Cell::ROW).toInt(),
-                       item->data(Cell::COL).toInt());
+    Cell cell = selected_points_["finish"];
+    emit finishUpdated(cell.first, cell.second);
   } else
     emit finishUpdated(0, 0);
 }
@@ -151,69 +539,51 @@ void MazeView::paintMazeSolution(std::vector<std::pair<int, int>> path) {
 
   // удаляется предыдущее решение лабиринта
   clearMazeSolution();
+  solution_ = std::move(path);
 
-  // удаляются текущие точки старта и финиша, они будут добавлены заново
-  // исходя из пути
-  if (selected_points_.contains("start"))
-    removePoint("start", selected_points_["start"]);
-  if (selected_points_.contains("finish"))
-    removePoint("finish", selected_points_["finish"]);
+  // точки старта и финиша берутся из пути
+  setPoint("start", solution_.front());
+  setPoint("finish", solution_.back());
 
+  // ломаная задана в координатах ячеек, толщина пера не зависит от масштаба
   QPen pen(color_map[Color::PATH_COLOR], PATH_THICKNESS, Qt::DashLine,
            Qt::FlatCap);
-
-  for (size_t i = 0; i < (path.size() - 1); i++) {
-    // поиск текущей и следующей ячеек на сцене по координатам элементов пути
-    QGraphicsRectItem *cell = findCell(path[i].first, path[i].second);
-    QGraphicsRectItem *next_cell =
-        findCell(path[i + 1].first, path[i + 1].second);
-
-    if (cell == nullptr || next_cell == nullptr) return;
-
-    QPointF cell_center = cell->sceneBoundingRect().center();
-    QPointF next_cell_center = next_cell->sceneBoundingRect().center();
-
-    // отрисовка линии между центрами двух ячеек
-    scene_->addLine(QLineF(cell_center, next_cell_center), pen);
-
-    // точки старта и финиша обновляются
-    if (i == 0) {
-      setPoint("start", cell);
-    }
-    if (i == path.size() - 2) {
-      setPoint("finish", next_cell);
-    }
-  }
-  update();
+  pen.setCosmetic(true);
+  solution_item_ = scene_->addPath(solutionPath(), pen);
+  updateView();
 }
 
-QGraphicsRectItem *MazeView::findCell(int row, int col) {
-  for (QGraphicsItem *item : scene_->items()) {
-    QGraphicsRectItem *rect = qgraphicsitem_cast<QGraphicsRectItem *>(item);
-    if (rect && rect->data(Cell::ROW).toInt() == row &&
-        rect->data(Cell::COL).toInt() == col) {
-      return rect;
-    }
+QPainterPath MazeView::solutionPath() const {
+  QPainterPath path;
+  if (solution_.empty()) return path;
+  auto center = [](Cell cell) {
+    return QPointF(cell.second + 0.5, cell.first + 0.5);
+  };
+  path.moveTo(center(solution_.front()));
+  // шаг пути от ячейки i - 1 к ячейке i
+  auto step = [this](size_t i) {
+    return Cell(solution_[i].first - solution_[i - 1].first,
+                solution_[i].second - solution_[i - 1].second);
+  };
+  for (size_t i = 1; i < solution_.size(); i++) {
+    // вершина нужна только там, где меняется направление шага
+    if (i + 1 < solution_.size() && step(i) == step(i + 1)) continue;
+    path.lineTo(center(solution_[i]));
   }
-  return nullptr;
+  return path;
 }
 
 void MazeView::clearMazeSolution() {
-  for (QGraphicsItem *item : scene_->items()) {
-    QGraphicsLineItem *line = qgraphicsitem_cast<QGraphicsLineItem *>(item);
-    if (line) {
-      scene_->removeItem(line);
-      delete line;
-    }
+  solution_.clear();
+  if (solution_item_) {
+    scene_->removeItem(solution_item_);
+    delete solution_item_;
+    solution_item_ = nullptr;
   }
 }
 
-void MazeView::setPoint(QString type, QGraphicsRectItem *rect) {
-  selected_points_.insert(type, rect);
-  rect->setData(Cell::PRESSED, true);
+void MazeView::setPoint(QString type, Cell cell) {
+  selected_points_.insert(type, cell);
 }
 
-void MazeView::removePoint(QString type, QGraphicsRectItem *rect) {
-  selected_points_.remove(type);
-  rect->setData(Cell::PRESSED, false);
-}
\ No newline at end of file
+void MazeView::removePoint(QString type) { selected_points_.remove(type); }
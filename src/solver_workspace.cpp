@@ -0,0 +1,37 @@
+#include "../include/solver_workspace.h"
+
+#include <algorithm>
+
+SolverWorkspace::SolverWorkspace() : generation_(0), expanded_(0) {}
+
+SolverWorkspace::SolverWorkspace(int cells) : SolverWorkspace() {
+  reset(cells);
+}
+
+void SolverWorkspace::reset(int cells, int sides, bool distances) {
+  if (cells > capacity()) {
+    // новые отметки равны 0 и не совпадут ни с одним поколением после ++
+    marks_.resize(cells, 0);
+    parent_.resize(cells, -1);
+  }
+  // очереди выделяются под емкость отметок, вторая - только по требованию
+  for (int side = 0; side < sides; side++) {
+    if (queues_[side].buffer.size() < marks_.size())
+      queues_[side].buffer.resize(marks_.size(), 0);
+  }
+  if (distances && distance_.size() < marks_.size())
+    distance_.resize(marks_.size(), 0);
+  // при переполнении счетчика поколений отметки очищаются полностью
+  if (++generation_ == (1u << 31)) {
+    std::fill(marks_.begin(), marks_.end(), 0);
+    generation_ = 1;
+  }
+  for (RingQueue &queue : queues_) {
+    queue.head = 0;
+    queue.tail = 0;
+    queue.size = 0;
+  }
+  heap_queue_.clear();
+  bucket_queue_.clear();
+  expanded_ = 0;
+}
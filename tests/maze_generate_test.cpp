@@ -60,4 +60,185 @@ TEST(generate_maze, edge_cases) {
   EXPECT_EQ(maze5.getRows(), 0);
   EXPECT_TRUE(maze5.grid().empty());
   EXPECT_TRUE(maze5.isEmpty());
-}
\ No newline at end of file
+}
+
+TEST(generate_maze, perfect) {
+  MazeBuilder builder;
+  // каждый сгенерированный лабиринт - дерево: без петель и изолированных зон
+  for (auto [rows, cols] : {std::pair{1, 1}, {1, 40}, {40, 1}, {17, 23}}) {
+    Maze maze = builder.createMaze(rows, cols);
+    EXPECT_TRUE(MazeTreeIndex(maze.grid()).isValid());
+  }
+
+  // широкая строка генерируется за линейное время
+  Maze wide = builder.createMaze(3, 100000);
+  EXPECT_EQ(wide.getCols(), 100000);
+  EXPECT_TRUE(MazeTreeIndex(wide.grid()).isValid());
+}
+
+TEST(generate_maze, streaming) {
+  MazeBuilder builder;
+  // строки приходят по порядку, каждая - представление из одной строки
+  MazeGrid collected(30, 20);
+  int expected_row = 0;
+  bool completed = builder.generate(30, 20, [&](int row, MazeGridView line) {
+    EXPECT_EQ(row, expected_row++);
+    EXPECT_EQ(line.rows(), 1);
+    EXPECT_EQ(line.cols(), 20);
+    collected.copyRow(line, 0, row);
+    return true;
+  });
+  EXPECT_TRUE(completed);
+  EXPECT_EQ(expected_row, 30);
+  EXPECT_TRUE(MazeTreeIndex(collected).isValid());
+
+  // приемник может прервать генерацию
+  int received = 0;
+  completed = builder.generate(30, 20, [&received](int row, MazeGridView) {
+    received++;
+    return row < 4;
+  });
+  EXPECT_FALSE(completed);
+  EXPECT_EQ(received, 5);
+
+  EXPECT_FALSE(builder.generate(0, 20, [](int, MazeGridView) { return true; }));
+}
+
+TEST(generate_maze, seed) {
+  MazeBuilder builder;
+  // одинаковое зерно дает одинаковый лабиринт
+  Maze maze = builder.createMaze(40, 70, 12345);
+  EXPECT_EQ(builder.lastSeed(), 12345u);
+  EXPECT_TRUE(maze.grid_ == builder.createMaze(40, 70, 12345).grid_);
+  EXPECT_FALSE(maze.grid_ == builder.createMaze(40, 70, 12346).grid_);
+  EXPECT_TRUE(MazeTreeIndex(maze.grid()).isValid());
+
+  // лабиринт без явного зерна воспроизводится по lastSeed
+  Maze random_maze = builder.createMaze(25, 25);
+  MazeBuilder other;
+  EXPECT_TRUE(random_maze.grid_ ==
+              other.createMaze(25, 25, builder.lastSeed()).grid_);
+
+  // построители с одинаковым зерном выдают одинаковые лабиринты
+  MazeBuilder first(7), second(7);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_TRUE(first.createMaze(10, 10).grid_ ==
+                second.createMaze(10, 10).grid_);
+  }
+}
+
+TEST(generate_maze, kernels) {
+  MazeBuilder scalar, bitwise;
+  scalar.setKernel(MazeBuilder::SCALAR);
+  bitwise.setKernel(MazeBuilder::BIT_PARALLEL);
+  EXPECT_EQ(bitwise.kernel(), MazeBuilder::BIT_PARALLEL);
+
+  // ширины вокруг границ 64-битных слов
+  for (int cols : {1, 2, 63, 64, 65, 127, 128, 129, 300}) {
+    for (std::uint64_t seed = 1; seed <= 5; seed++) {
+      Maze expected = scalar.createMaze(20, cols, seed);
+      Maze actual = bitwise.createMaze(20, cols, seed);
+      EXPECT_TRUE(expected.grid_ == actual.grid_) << cols << ' ' << seed;
+    }
+  }
+}
+
+TEST(generate_maze, parallel) {
+  MazeBuilder builder;
+  // три полосы, последняя неполная
+  int rows = 2 * MazeBuilder::STRIP_ROWS + 37;
+  Maze maze = builder.createMazeParallel(rows, 50, 99, 4);
+  EXPECT_EQ(maze.getRows(), rows);
+  EXPECT_EQ(maze.getCols(), 50);
+  EXPECT_EQ(builder.lastSeed(), 99u);
+  EXPECT_TRUE(MazeTreeIndex(maze.grid()).isValid());
+
+  // результат не зависит от количества потоков
+  EXPECT_TRUE(maze.grid_ == builder.createMazeParallel(rows, 50, 99, 1).grid_);
+  EXPECT_FALSE(maze.grid_ == builder.createMazeParallel(rows, 50, 98, 4).grid_);
+
+  Maze narrow = builder.createMazeParallel(rows, 1, 1);
+  EXPECT_TRUE(MazeTreeIndex(narrow.grid()).isValid());
+  EXPECT_TRUE(builder.createMazeParallel(0, 10, 1).isEmpty());
+}
+
+TEST(generate_maze, algorithms) {
+  MazeBuilder builder;
+  for (MazeBuilder::Algorithm algorithm :
+       {MazeBuilder::ELLER, MazeBuilder::SIDEWINDER, MazeBuilder::BINARY_TREE,
+        MazeBuilder::WILSON, MazeBuilder::KRUSKAL}) {
+    builder.setAlgorithm(algorithm);
+    EXPECT_EQ(builder.algorithm(), algorithm);
+    for (auto [rows, cols] : {std::pair{1, 1}, {1, 70}, {70, 1}, {31, 67}}) {
+      Maze maze = builder.createMaze(rows, cols, 2024);
+      EXPECT_TRUE(MazeTreeIndex(maze.grid()).isValid())
+          << algorithm << ' ' << rows << ' ' << cols;
+      EXPECT_TRUE(maze.grid_ == builder.createMaze(rows, cols, 2024).grid_);
+
+      // построчная генерация дает тот же лабиринт
+      MazeGrid streamed(rows, cols);
+      builder.generate(rows, cols, 2024, [&](int row, MazeGridView line) {
+        streamed.copyRow(line, 0, row);
+        return true;
+      });
+      EXPECT_TRUE(maze.grid_ == streamed) << algorithm;
+    }
+
+    int rows = MazeBuilder::STRIP_ROWS + 5;
+    Maze parallel = builder.createMazeParallel(rows, 9, 1);
+    EXPECT_TRUE(MazeTreeIndex(parallel.grid()).isValid()) << algorithm;
+  }
+}
+
+TEST(generate_maze, descriptor) {
+  MazeBuilder builder;
+  int rows = 2 * MazeBuilder::STRIP_ROWS + 11;
+  for (MazeBuilder::Algorithm algorithm :
+       {MazeBuilder::ELLER, MazeBuilder::SIDEWINDER, MazeBuilder::BINARY_TREE,
+        MazeBuilder::WILSON, MazeBuilder::KRUSKAL}) {
+    builder.setAlgorithm(algorithm);
+    for (bool strips : {false, true}) {
+      MazeDescriptor descriptor = builder.describe(rows, 21, 77, strips);
+      EXPECT_TRUE(MazeBuilder::isValid(descriptor));
+      Maze maze = strips ? builder.createMazeParallel(rows, 21, 77)
+                         : builder.createMaze(rows, 21, 77);
+
+      // генерация по описанию не меняет алгоритм строителя
+      builder.setAlgorithm(MazeBuilder::ELLER);
+      EXPECT_TRUE(builder.createMaze(descriptor).grid_ == maze.grid_);
+      EXPECT_EQ(builder.algorithm(), MazeBuilder::ELLER);
+      EXPECT_EQ(builder.lastSeed(), 77u);
+
+      // диапазон строк, пересекающий границу полос
+      int first_row = MazeBuilder::STRIP_ROWS - 3;
+      int received = 0;
+      EXPECT_TRUE(builder.generate(
+          descriptor, first_row, 10, [&](int row, MazeGridView line) {
+            for (int col = 0; col < 21; col++)
+              EXPECT_EQ(line.at(0, col), maze.grid_.at(row, col))
+                  << algorithm << ' ' << strips << ' ' << row;
+            EXPECT_EQ(row, first_row + received++);
+            return true;
+          }));
+      EXPECT_EQ(received, 10);
+      EXPECT_FALSE(builder.generate(descriptor, rows - 2, 3,
+                                    [](int, MazeGridView) { return true; }));
+      EXPECT_EQ(builder.algorithm(), MazeBuilder::ELLER);
+      builder.setAlgorithm(algorithm);
+    }
+  }
+
+  MazeDescriptor descriptor = builder.describe(10, 10, 1);
+  descriptor.version = MazeBuilder::GENERATOR_VERSION + 1;
+  EXPECT_FALSE(MazeBuilder::isValid(descriptor));
+  EXPECT_TRUE(builder.createMaze(descriptor).isEmpty());
+
+  // номера ячеек такого лабиринта не помещаются в int
+  descriptor = builder.describe(50000, 50000, 1);
+  EXPECT_FALSE(MazeBuilder::isValid(descriptor));
+  EXPECT_TRUE(builder.createMaze(descriptor).isEmpty());
+  EXPECT_FALSE(builder.generate(descriptor, 0, 1,
+                                [](int, MazeGridView) { return true; }));
+  descriptor = builder.describe(1 << 15, (1 << 15) - 1, 1);
+  EXPECT_TRUE(MazeBuilder::isValid(descriptor));
+}
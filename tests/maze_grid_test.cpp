@@ -0,0 +1,88 @@
+#include "test.h"
+
+TEST(maze_grid, common) {
+  MazeGrid grid(3, 70);
+
+  EXPECT_EQ(grid.rows(), 3);
+  EXPECT_EQ(grid.cols(), 70);
+  EXPECT_EQ(grid.wordsPerRow(), 2);
+  EXPECT_EQ(grid.sizeInBytes(), 3 * 2 * 2 * sizeof(std::uint64_t));
+  EXPECT_FALSE(grid.empty());
+  EXPECT_EQ(grid.at(2, 69), MazeGrid::Wall::NONE);
+
+  grid.set(1, 65, MazeGrid::Wall::BOTH);
+  EXPECT_TRUE(grid.hasRightWall(1, 65));
+  EXPECT_TRUE(grid.hasDownWall(1, 65));
+  EXPECT_FALSE(grid.hasRightWall(1, 64));
+  EXPECT_FALSE(grid.hasDownWall(0, 65));
+
+  grid.removeWalls(1, 65, MazeGrid::Wall::RIGHT);
+  EXPECT_EQ(grid.at(1, 65), MazeGrid::Wall::DOWN);
+
+  grid.addWalls(1, 0, MazeGrid::Wall::RIGHT);
+  grid.copyRow(1, 2);
+  EXPECT_EQ(grid.at(2, 0), MazeGrid::Wall::RIGHT);
+  EXPECT_EQ(grid.at(2, 65), MazeGrid::Wall::DOWN);
+  EXPECT_EQ(grid.at(0, 0), MazeGrid::Wall::NONE);
+}
+
+TEST(maze_grid, edge_cases) {
+  MazeGrid grid;
+  EXPECT_TRUE(grid.empty());
+  EXPECT_EQ(grid.sizeInBytes(), 0);
+
+  MazeGrid grid2(-1, 5);
+  EXPECT_TRUE(grid2.empty());
+  EXPECT_EQ(grid2.rows(), 0);
+  EXPECT_EQ(grid2.cols(), 0);
+
+  MazeGrid grid3(1, 64);
+  EXPECT_EQ(grid3.wordsPerRow(), 1);
+  grid3.set(0, 63, MazeGrid::Wall::RIGHT);
+  EXPECT_TRUE(grid3.hasRightWall(0, 63));
+  EXPECT_EQ(grid3, grid3);
+  EXPECT_FALSE(grid3 == MazeGrid(1, 64));
+}
+
+TEST(maze_grid, view) {
+  MazeGrid grid(4, 100);
+  grid.set(3, 99, MazeGrid::Wall::BOTH);
+  grid.set(0, 70, MazeGrid::Wall::RIGHT);
+
+  MazeGridView view = grid;
+  EXPECT_EQ(view.rows(), 4);
+  EXPECT_EQ(view.cols(), 100);
+  EXPECT_EQ(view.wordsPerRow(), grid.wordsPerRow());
+  EXPECT_EQ(view.at(3, 99), MazeGrid::Wall::BOTH);
+  EXPECT_EQ(view.at(0, 70), MazeGrid::Wall::RIGHT);
+
+  // представление ссылается на буфер хранилища, а не на его копию
+  EXPECT_EQ(view.rightRow(2), grid.rightRow(2));
+  grid.addWalls(1, 1, MazeGrid::Wall::DOWN);
+  EXPECT_TRUE(view.hasDownWall(1, 1));
+
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(10, 10);
+  EXPECT_EQ(maze.grid().downRow(9), maze.grid_.downRow(9));
+
+  EXPECT_TRUE(MazeGridView().empty());
+}
+
+TEST(maze_grid, fill) {
+  MazeGrid grid(3, 70);
+  grid.fill(MazeGrid::BOTH);
+  EXPECT_EQ(grid.at(0, 0), MazeGrid::BOTH);
+  EXPECT_EQ(grid.at(2, 69), MazeGrid::BOTH);
+  // биты за последним столбцом не заполняются
+  EXPECT_EQ(grid.rightRow(1)[1], (std::uint64_t{1} << 6) - 1);
+
+  grid.fill(MazeGrid::DOWN);
+  EXPECT_EQ(grid.at(1, 65), MazeGrid::DOWN);
+  EXPECT_EQ(grid.rightRow(2)[0], 0u);
+  EXPECT_TRUE(grid == [] {
+    MazeGrid expected(3, 70);
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 70; j++) expected.set(i, j, MazeGrid::DOWN);
+    return expected;
+  }());
+}
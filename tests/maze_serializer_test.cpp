@@ -0,0 +1,302 @@
+#include "test.h"
+
+TEST(serializer, text) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(12, 70, 3);
+  std::string path = tempFilePath("maze_serializer_text.txt");
+  MazeSerializer::saveToFile(maze.grid(), path);
+
+  Maze loaded = MazeSerializer::readFromFile(path);
+  EXPECT_TRUE(loaded.grid_ == maze.grid_);
+  EXPECT_FALSE(loaded.grid_.isExternal());
+  std::filesystem::remove(path);
+
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+}
+
+TEST(serializer, binary) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(33, 130, 5);
+  std::string path = tempFilePath("maze_serializer_binary.maze");
+  MazeSerializer::saveToBinaryFile(maze.grid(), path, builder.lastSeed());
+
+  MazeFileHeader header;
+  ASSERT_TRUE(MazeSerializer::readBinaryHeader(path, header));
+  EXPECT_EQ(header.rows, 33);
+  EXPECT_EQ(header.cols, 130);
+  EXPECT_EQ(header.flags, MazeSerializer::FLAG_HAS_SEED);
+  EXPECT_EQ(header.seed, 5u);
+  EXPECT_EQ(std::filesystem::file_size(path),
+            sizeof(MazeFileHeader) + maze.grid_.sizeInBytes());
+
+  // формат определяется по сигнатуре, стены читаются из файла без копирования
+  Maze loaded = MazeSerializer::readFromFile(path);
+  EXPECT_TRUE(loaded.grid_ == maze.grid_);
+  EXPECT_EQ(loaded.getRows(), 33);
+  EXPECT_EQ(loaded.getCols(), 130);
+  EXPECT_TRUE(MazeTreeIndex(loaded.grid()).isValid());
+  EXPECT_FALSE(loaded.getSolution(0, 0, 32, 129).empty());
+
+  // изменения стен не попадают в файл, копия получает свой буфер
+  Maze copy = loaded;
+  loaded.grid_.fill(MazeGrid::NONE);
+  EXPECT_FALSE(copy.grid_.isExternal());
+  EXPECT_TRUE(copy.grid_ == maze.grid_);
+  Maze verified = MazeSerializer::readFromBinaryFile(path, true);
+  EXPECT_TRUE(verified.grid_ == maze.grid_);
+  std::filesystem::remove(path);
+}
+
+TEST(serializer, binary_errors) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(10, 10, 7);
+  std::string path = tempFilePath("maze_serializer_errors.maze");
+  MazeSerializer::saveToBinaryFile(maze.grid(), path);
+
+  // испорченные стены находит проверка контрольной суммы, которую общий
+  // загрузчик выполняет всегда
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(sizeof(MazeFileHeader));
+    file.put('\xff');
+  }
+  EXPECT_FALSE(MazeSerializer::readFromBinaryFile(path).isEmpty());
+  EXPECT_TRUE(MazeSerializer::readFromBinaryFile(path, true).isEmpty());
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+
+  // обрезанный файл отвергается по заголовку
+  std::filesystem::resize_file(path, sizeof(MazeFileHeader) + 8);
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+  std::filesystem::remove(path);
+
+  EXPECT_TRUE(MazeSerializer::readFromBinaryFile(path).isEmpty());
+}
+
+TEST(serializer, compressed) {
+  MazeBuilder builder;
+  builder.setAlgorithm(MazeBuilder::BINARY_TREE);
+  Maze maze = builder.createMaze(100, 130, 9);
+  std::string path = tempFilePath("maze_serializer_compressed.mazez");
+  MazeSerializer::saveToCompressedFile(maze.grid(), path, 9, 16);
+
+  MazeFileHeader header;
+  ASSERT_TRUE(MazeSerializer::readBinaryHeader(path, header));
+  EXPECT_EQ(header.block_rows, 16);
+  EXPECT_EQ(header.seed, 9u);
+  EXPECT_LT(std::filesystem::file_size(path), maze.grid_.sizeInBytes() / 2);
+
+  Maze loaded = MazeSerializer::readFromFile(path);
+  EXPECT_TRUE(loaded.grid_ == maze.grid_);
+  EXPECT_FALSE(loaded.grid_.isExternal());
+
+  // диапазон строк распаковывается по блокам без чтения всего файла
+  MazeGrid rows(30, 130);
+  EXPECT_TRUE(MazeSerializer::readCompressedRows(
+      path, 45, 30, [&rows](int row, MazeGridView line) {
+        rows.copyRow(line, 0, row - 45);
+        return true;
+      }));
+  for (int row = 0; row < 30; row++)
+    for (int col = 0; col < 130; col++)
+      EXPECT_EQ(rows.at(row, col), maze.grid_.at(row + 45, col));
+
+  // приемник может прервать чтение
+  int received = 0;
+  EXPECT_FALSE(MazeSerializer::readCompressedRows(
+      path, 0, 100, [&received](int, MazeGridView) { return ++received < 5; }));
+  EXPECT_EQ(received, 5);
+  EXPECT_FALSE(MazeSerializer::readCompressedRows(path, 90, 20,
+                                                  [](int, MazeGridView) {
+                                                    return true;
+                                                  }));
+  std::filesystem::remove(path);
+}
+
+TEST(serializer, compressed_algorithms) {
+  MazeBuilder builder;
+  for (MazeBuilder::Algorithm algorithm :
+       {MazeBuilder::ELLER, MazeBuilder::SIDEWINDER, MazeBuilder::BINARY_TREE,
+        MazeBuilder::WILSON, MazeBuilder::KRUSKAL}) {
+    builder.setAlgorithm(algorithm);
+    Maze maze = builder.createMaze(70, 90, 11);
+    std::string path = tempFilePath("maze_serializer_algorithms.mazez");
+    MazeSerializer::saveToCompressedFile(maze.grid(), path);
+    EXPECT_LT(std::filesystem::file_size(path),
+              sizeof(MazeFileHeader) + maze.grid_.sizeInBytes());
+    EXPECT_TRUE(MazeSerializer::readFromFile(path).grid_ == maze.grid_);
+    std::filesystem::remove(path);
+  }
+
+  // лабиринт с петлями сжимается хуже, но восстанавливается точно
+  MazeGrid grid(20, 20);
+  for (int row = 0; row < 20; row++)
+    for (int col = 0; col < 20; col++) grid.set(row, col, (row * col) % 4);
+  std::string path = tempFilePath("maze_serializer_loops.mazez");
+  MazeSerializer::saveToCompressedFile(grid.view(), path, {}, 7);
+  EXPECT_TRUE(MazeSerializer::readFromCompressedFile(path).grid_ == grid);
+  std::filesystem::remove(path);
+}
+
+TEST(serializer, compressed_errors) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(40, 40, 13);
+  std::string path = tempFilePath("maze_serializer_corrupted.mazez");
+  MazeSerializer::saveToCompressedFile(maze.grid(), path, {}, 8);
+
+  // испорченный блок находит контрольная сумма
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(-4, std::ios::end);
+    file.put('\x5a');
+  }
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+
+  // при чтении части строк испорченный блок находит его контрольная сумма,
+  // строки блока приемнику не передаются
+  MazeSerializer::saveToCompressedFile(maze.grid(), path, {}, 8);
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    std::uint64_t offsets[3];
+    file.seekg(sizeof(MazeFileHeader));
+    file.read(reinterpret_cast<char *>(offsets), sizeof(offsets));
+    file.seekp(offsets[1] + (offsets[2] - offsets[1]) / 2);
+    file.put('\x5a');
+  }
+  int received = 0;
+  auto count = [&received](int, MazeGridView) { return ++received > 0; };
+  EXPECT_TRUE(MazeSerializer::readCompressedRows(path, 0, 8, count));
+  EXPECT_FALSE(MazeSerializer::readCompressedRows(path, 4, 10, count));
+  EXPECT_EQ(received, 8 + 4);
+
+  // без контрольных сумм блоков обрезанные данные находит декодер
+  std::vector<std::uint8_t> data = MazeCodec::encodeRows(maze.grid(), 0, 8);
+  MazeGrid rows(8, 40);
+  EXPECT_TRUE(MazeCodec::decodeRows(data.data(), data.size(), 0, 40, rows));
+  EXPECT_FALSE(
+      MazeCodec::decodeRows(data.data(), data.size() - 2, 0, 40, rows));
+
+  // небольшой сжатый файл не может объявить больше MAX_CELLS ячеек
+  MazeSerializer::saveToCompressedFile(maze.grid(), path, {}, 8);
+  MazeFileHeader header;
+  ASSERT_TRUE(MazeSerializer::readBinaryHeader(path, header));
+  header.rows = header.cols = header.block_rows = 50000;
+  header.words_per_row = (50000 + MazeGrid::WORD_BITS - 1) /
+                         MazeGrid::WORD_BITS;
+  {
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  }
+  EXPECT_FALSE(MazeSerializer::readBinaryHeader(path, header));
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+
+  std::filesystem::resize_file(path, sizeof(MazeFileHeader) + 8);
+  EXPECT_TRUE(MazeSerializer::readFromCompressedFile(path).isEmpty());
+  std::filesystem::remove(path);
+}
+
+TEST(serializer, compressed_stream) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(1000, 70, 17);
+  std::string path = tempFilePath("maze_serializer_stream.mazez");
+
+  // строки генератора сжимаются по мере готовности, лабиринт целиком в
+  // памяти не собирается
+  {
+    MazeCompressedWriter writer(path, 1000, 70, 17u, 64);
+    ASSERT_TRUE(writer.isOpen());
+    EXPECT_TRUE(builder.generate(1000, 70, 17, writer.sink()));
+    EXPECT_TRUE(writer.finish());
+  }
+
+  MazeFileHeader header;
+  ASSERT_TRUE(MazeSerializer::readBinaryHeader(path, header));
+  EXPECT_EQ(header.block_rows, 64);
+  EXPECT_EQ(header.seed, 17u);
+  EXPECT_EQ(header.checksum, MazeSerializer::checksum(maze.grid()));
+
+  // строки на стыке блоков распаковываются без остальных
+  int next = 90;
+  EXPECT_TRUE(MazeSerializer::readCompressedRows(
+      path, 90, 300, [&](int row, MazeGridView line) {
+        EXPECT_EQ(row, next++);
+        for (int col = 0; col < 70; col++)
+          EXPECT_EQ(line.at(0, col), maze.grid_.at(row, col));
+        return true;
+      }));
+  EXPECT_EQ(next, 390);
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).grid_ == maze.grid_);
+
+  // файл совпадает с записанным из готового лабиринта
+  std::string saved = tempFilePath("maze_serializer_saved.mazez");
+  MazeSerializer::saveToCompressedFile(maze.grid(), saved, 17u, 64);
+  std::ifstream stream_file(path, std::ios::binary);
+  std::ifstream saved_file(saved, std::ios::binary);
+  EXPECT_TRUE(std::equal(std::istreambuf_iterator<char>(stream_file), {},
+                         std::istreambuf_iterator<char>(saved_file), {}));
+  std::filesystem::remove(saved);
+
+  // строки не по порядку и неполный лабиринт отвергаются
+  {
+    MazeCompressedWriter writer(path, 10, 70);
+    EXPECT_FALSE(writer.append(1, maze.grid()));
+    EXPECT_TRUE(writer.append(0, maze.grid()));
+    EXPECT_FALSE(writer.finish());
+  }
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+  std::filesystem::remove(path);
+}
+
+TEST(serializer, descriptor) {
+  MazeBuilder builder;
+  builder.setAlgorithm(MazeBuilder::SIDEWINDER);
+  Maze maze = builder.createMaze(300, 40, 21);
+  std::string path = tempFilePath("maze_serializer_descriptor.mazegen");
+  MazeSerializer::saveDescriptor(builder.describe(300, 40, 21), path);
+  EXPECT_EQ(std::filesystem::file_size(path), 8 + sizeof(MazeDescriptor));
+
+  MazeDescriptor descriptor;
+  ASSERT_TRUE(MazeSerializer::readDescriptor(path, descriptor));
+  EXPECT_EQ(descriptor.algorithm, MazeBuilder::SIDEWINDER);
+  EXPECT_EQ(descriptor.seed, 21u);
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).grid_ == maze.grid_);
+
+  MazeGrid rows(5, 40);
+  EXPECT_TRUE(MazeSerializer::readDescriptorRows(
+      path, 200, 5, [&rows](int row, MazeGridView line) {
+        rows.copyRow(line, 0, row - 200);
+        return true;
+      }));
+  for (int row = 0; row < 5; row++)
+    for (int col = 0; col < 40; col++)
+      EXPECT_EQ(rows.at(row, col), maze.grid_.at(row + 200, col));
+
+  // описание другой версии генераторов не читается
+  descriptor.version++;
+  MazeSerializer::saveDescriptor(descriptor, path);
+  EXPECT_TRUE(MazeSerializer::readFromFile(path).isEmpty());
+  std::filesystem::remove(path);
+}
+
+TEST(serializer, text_format) {
+  std::string path = tempFilePath("maze_serializer_format.txt");
+  auto load = [&path](const std::string &text) {
+    std::ofstream(path, std::ios::binary) << text;
+    return MazeSerializer::readFromFile(path);
+  };
+
+  // переводы строк Windows, лишние пробелы и числа кроме 0 и 1
+  Maze maze = load("2 3\r\n0 1  1\r\n\t1 0 1\r\n\r\n1 1 1\r\n0 2 1");
+  ASSERT_EQ(maze.getRows(), 2);
+  ASSERT_EQ(maze.getCols(), 3);
+  EXPECT_EQ(maze.grid().at(0, 0), MazeGrid::DOWN);
+  EXPECT_EQ(maze.grid().at(0, 1), MazeGrid::BOTH);
+  EXPECT_EQ(maze.grid().at(1, 1), MazeGrid::DOWN);
+  EXPECT_EQ(maze.grid().at(1, 2), MazeGrid::BOTH);
+
+  EXPECT_TRUE(load("").isEmpty());
+  EXPECT_TRUE(load("2 2\n0 1\n1 1\n\n0 x\n1 1\n").isEmpty());
+  EXPECT_TRUE(load("2 2\n0 1\n1 1\n\n0 1\n1\n").isEmpty());
+  EXPECT_TRUE(load("2 2\n0 1\n1 1\n\n0 1\n1 -\n").isEmpty());
+  EXPECT_TRUE(load("0 5\n").isEmpty());
+  std::filesystem::remove(path);
+}
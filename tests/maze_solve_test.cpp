@@ -7,20 +7,7 @@ TEST(solve_maze, common) {
 
   EXPECT_EQ(maze.getCols(), 5);
   EXPECT_EQ(maze.getRows(), 5);
-  EXPECT_FALSE(maze.graph_.empty());
-  EXPECT_FALSE(maze.vertices_.empty());
-
-  Maze::Vertex begin = maze.vertices_.front().front();
-  Maze::Vertex test(0, 0, 0);
-  EXPECT_EQ(begin.id, test.id);
-  EXPECT_EQ(begin.row, test.row);
-  EXPECT_EQ(begin.col, test.col);
-
-  Maze::Vertex end = maze.vertices_.back().back();
-  Maze::Vertex test2(24, 4, 4);
-  EXPECT_EQ(end.id, test2.id);
-  EXPECT_EQ(end.row, test2.row);
-  EXPECT_EQ(end.col, test2.col);
+  EXPECT_FALSE(maze.grid_.empty());
 
   EXPECT_EQ(solution.front(), std::make_pair(0, 0));
   EXPECT_EQ(solution.back(), std::make_pair(4, 4));
@@ -30,23 +17,12 @@ TEST(solve_maze, common) {
 
   EXPECT_EQ(maze2.getCols(), 50);
   EXPECT_EQ(maze2.getRows(), 50);
-  EXPECT_FALSE(maze2.graph_.empty());
-  EXPECT_FALSE(maze2.vertices_.empty());
-
-  Maze::Vertex begin2 = maze2.vertices_.front().front();
-  Maze::Vertex test3(0, 0, 0);
-  EXPECT_EQ(begin2.id, test3.id);
-  EXPECT_EQ(begin2.row, test3.row);
-  EXPECT_EQ(begin2.col, test3.col);
-
-  Maze::Vertex end2 = maze2.vertices_.back().back();
-  Maze::Vertex test4(2499, 49, 49);
-  EXPECT_EQ(end2.id, test4.id);
-  EXPECT_EQ(end2.row, test4.row);
-  EXPECT_EQ(end2.col, test4.col);
+  EXPECT_FALSE(maze2.grid_.empty());
 
   EXPECT_EQ(solution2.front(), std::make_pair(0, 49));
   EXPECT_EQ(solution2.back(), std::make_pair(49, 0));
+
+  EXPECT_TRUE(isValidPath(maze2.grid_, solution2));
 }
 
 TEST(solve_maze, edge_cases) {
@@ -56,16 +32,12 @@ TEST(solve_maze, edge_cases) {
   std::vector<std::pair<int, int>> solution = maze.getSolution(0, 0, 4, 4);
 
   EXPECT_TRUE(maze.grid_.empty());
-  EXPECT_TRUE(maze.graph_.empty());
-  EXPECT_TRUE(maze.vertices_.empty());
   EXPECT_TRUE(solution.empty());
 
   Maze maze2 = builder.createMaze(1, 1);
   std::vector<std::pair<int, int>> solution2 = maze2.getSolution(0, 0, 0, 0);
 
   EXPECT_TRUE(!maze2.grid_.empty());
-  EXPECT_TRUE(!maze2.graph_.empty());
-  EXPECT_TRUE(!maze2.vertices_.empty());
   EXPECT_FALSE(solution2.empty());
   EXPECT_EQ(solution2.front(), std::make_pair(0, 0));
 
@@ -73,8 +45,6 @@ TEST(solve_maze, edge_cases) {
   std::vector<std::pair<int, int>> solution3 = maze3.getSolution(0, 0, 0, 1);
 
   EXPECT_FALSE(maze3.grid_.empty());
-  EXPECT_FALSE(maze3.graph_.empty());
-  EXPECT_FALSE(maze3.vertices_.empty());
   EXPECT_FALSE(solution3.empty());
   EXPECT_EQ(solution3.size(), 2);
   EXPECT_EQ(solution3.front(), std::make_pair(0, 0));
@@ -88,4 +58,177 @@ TEST(solve_maze, edge_cases) {
   std::vector<std::pair<int, int>> solution5 =
       maze5.getSolution(-1, 3, 15, -10);
   EXPECT_TRUE(solution5.empty());
-}
\ No newline at end of file
+}
+
+TEST(solve_maze, workspace) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(30, 40);
+  SolverWorkspace workspace;
+
+  auto solution = maze.getSolution(0, 0, 29, 39, workspace);
+  EXPECT_EQ(workspace.capacity(), 30 * 40);
+  EXPECT_EQ(solution.front(), std::make_pair(0, 0));
+  EXPECT_EQ(solution.back(), std::make_pair(29, 39));
+  EXPECT_TRUE(isValidPath(maze.grid_, solution));
+
+  // повторные поиски с той же рабочей памятью дают тот же результат
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(maze.getSolution(0, 0, 29, 39, workspace), solution);
+    EXPECT_EQ(maze.getSolution(0, 0, 29, 39), solution);
+  }
+  EXPECT_EQ(workspace.capacity(), 30 * 40);
+
+  // рабочая память большего лабиринта подходит и для меньшего
+  Maze maze2 = builder.createMaze(5, 5);
+  auto solution2 = maze2.getSolution(4, 4, 0, 0, workspace);
+  EXPECT_EQ(solution2.front(), std::make_pair(4, 4));
+  EXPECT_EQ(solution2.back(), std::make_pair(0, 0));
+  EXPECT_EQ(workspace.capacity(), 30 * 40);
+}
+
+TEST(solve_maze, bidirectional) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(40, 40);
+
+  // убираем часть стен, чтобы в лабиринте появились петли
+  for (int i = 0; i < 40; i += 3) {
+    for (int j = 0; j < 39; j += 5) {
+      maze.grid_.removeWalls(i, j, Maze::Wall::BOTH);
+    }
+  }
+
+  SolverWorkspace workspace;
+  std::pair<int, int> points[][2] = {{{0, 0}, {39, 39}},
+                                     {{39, 0}, {0, 39}},
+                                     {{20, 20}, {21, 20}},
+                                     {{5, 7}, {33, 12}}};
+  for (auto &[start, finish] : points) {
+    auto bfs = maze.getSolution(start.first, start.second, finish.first,
+                                finish.second, workspace, Maze::BFS);
+    auto bidirectional =
+        maze.getSolution(start.first, start.second, finish.first,
+                         finish.second, workspace, Maze::BIDIRECTIONAL_BFS);
+    EXPECT_EQ(bidirectional.size(), bfs.size());
+    EXPECT_EQ(bidirectional.front(), start);
+    EXPECT_EQ(bidirectional.back(), finish);
+    EXPECT_TRUE(isValidPath(maze.grid_, bidirectional));
+  }
+
+  auto single = maze.getSolution(3, 3, 3, 3, Maze::BIDIRECTIONAL_BFS);
+  EXPECT_EQ(single.size(), 1);
+
+  // изолированная ячейка недостижима
+  Maze maze2(2, 2);
+  maze2.grid_.addWalls(0, 0, Maze::Wall::BOTH);
+  EXPECT_TRUE(maze2.getSolution(0, 0, 1, 1, Maze::BIDIRECTIONAL_BFS).empty());
+  EXPECT_EQ(maze2.getSolution(0, 1, 1, 0, Maze::BIDIRECTIONAL_BFS).size(), 3);
+}
+
+TEST(solve_maze, a_star) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(40, 40);
+  for (int i = 0; i < 40; i += 3) {
+    for (int j = 0; j < 39; j += 5) {
+      maze.grid_.removeWalls(i, j, Maze::Wall::BOTH);
+    }
+  }
+
+  SolverWorkspace workspace;
+  for (Maze::SolveMethod method : {Maze::A_STAR, Maze::A_STAR_BUCKET}) {
+    auto bfs = maze.getSolution(0, 0, 39, 39, workspace, Maze::BFS);
+    auto a_star = maze.getSolution(0, 0, 39, 39, workspace, method);
+    EXPECT_EQ(a_star.size(), bfs.size());
+    EXPECT_EQ(a_star.front(), std::make_pair(0, 0));
+    EXPECT_EQ(a_star.back(), std::make_pair(39, 39));
+    EXPECT_TRUE(isValidPath(maze.grid_, a_star));
+
+    auto bfs2 = maze.getSolution(25, 3, 7, 30, workspace, Maze::BFS);
+    auto a_star2 = maze.getSolution(25, 3, 7, 30, workspace, method);
+    EXPECT_EQ(a_star2.size(), bfs2.size());
+    EXPECT_TRUE(isValidPath(maze.grid_, a_star2));
+  }
+
+  // в лабиринте без внутренних стен A* раскрывает лишь ячейки вдоль пути
+  Maze open(50, 50);
+  open.getSolution(0, 0, 49, 49, workspace, Maze::BFS);
+  int bfs_expanded = workspace.expanded();
+  for (Maze::SolveMethod method : {Maze::A_STAR, Maze::A_STAR_BUCKET}) {
+    auto path = open.getSolution(0, 0, 49, 49, workspace, method);
+    EXPECT_EQ(path.size(), 99);
+    EXPECT_LT(workspace.expanded() * 10, bfs_expanded);
+  }
+
+  // недостижимая точка
+  Maze closed(2, 2);
+  closed.grid_.addWalls(0, 0, Maze::Wall::BOTH);
+  EXPECT_TRUE(closed.getSolution(1, 1, 0, 0, Maze::A_STAR).empty());
+  EXPECT_TRUE(closed.getSolution(1, 1, 0, 0, Maze::A_STAR_BUCKET).empty());
+}
+
+TEST(solve_maze, distance_field) {
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(30, 20);
+
+  Maze::DistanceField field = maze.getDistanceField({{0, 0}});
+  EXPECT_EQ(field.rows, 30);
+  EXPECT_EQ(field.cols, 20);
+  EXPECT_EQ(field.distanceAt(0, 0), 0);
+  for (int i = 0; i < 30; i += 7) {
+    for (int j = 0; j < 20; j += 3) {
+      EXPECT_EQ(field.distanceAt(i, j),
+                static_cast<int>(maze.getSolution(0, 0, i, j).size()) - 1);
+    }
+  }
+
+  // поле от нескольких источников - минимум полей от каждого из них
+  Maze::DistanceField first = maze.getDistanceField({{0, 19}});
+  Maze::DistanceField second = maze.getDistanceField({{29, 0}});
+  Maze::DistanceField both =
+      maze.getDistanceField({{0, 19}, {29, 0}, {29, 0}, {-1, 100}});
+  for (int id = 0; id < 30 * 20; id++) {
+    EXPECT_EQ(both.distance[id],
+              std::min(first.distance[id], second.distance[id]));
+    // цепочка родителей ведет к ближайшему источнику
+    int steps = 0, current = id;
+    while (both.parent[current] != -1) {
+      current = both.parent[current];
+      steps++;
+    }
+    EXPECT_EQ(steps, both.distance[id]);
+    EXPECT_EQ(both.distance[current], 0);
+  }
+
+  Maze empty(0, 0);
+  EXPECT_TRUE(empty.getDistanceField({{0, 0}}).distance.empty());
+
+  Maze closed(2, 2);
+  closed.grid_.addWalls(0, 0, Maze::Wall::BOTH);
+  Maze::DistanceField isolated = closed.getDistanceField({{1, 1}});
+  EXPECT_EQ(isolated.distanceAt(0, 0), -1);
+  EXPECT_EQ(isolated.distanceAt(1, 0), 1);
+}
+
+TEST(solve_maze, batch) {
+  MazeBuilder builder;
+  const Maze maze = builder.createMaze(60, 60);
+
+  std::vector<Maze::Query> queries;
+  for (int k = 0; k < 200; k++) {
+    queries.push_back({k % 60, (k * 7) % 60, (k * 13) % 60, (k * 29) % 60});
+  }
+  queries.push_back({-1, 0, 0, 0});
+
+  for (Maze::SolveMethod method :
+       {Maze::BFS, Maze::BIDIRECTIONAL_BFS, Maze::A_STAR_BUCKET,
+        Maze::TREE_INDEX}) {
+    auto paths = maze.solveBatch(queries, method, 4);
+    ASSERT_EQ(paths.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+      const Maze::Query &q = queries[i];
+      EXPECT_EQ(paths[i], maze.getSolution(q.row1, q.col1, q.row2, q.col2));
+    }
+  }
+
+  EXPECT_EQ(maze.solveBatch(queries).size(), queries.size());
+  EXPECT_TRUE(maze.solveBatch({}).empty());
+}
@@ -0,0 +1,112 @@
+#include "test.h"
+
+TEST(tree_index, common) {
+  MazeBuilder builder;
+  std::pair<int, int> sizes[] = {{1, 1}, {1, 50}, {50, 1}, {7, 13}, {60, 45}};
+
+  for (auto [rows, cols] : sizes) {
+    Maze maze = builder.createMaze(rows, cols);
+    MazeTreeIndex index(maze.grid_);
+    EXPECT_TRUE(index.isValid());
+    EXPECT_TRUE(maze.buildTreeIndex());
+
+    SolverWorkspace workspace;
+    for (int k = 0; k < 50; k++) {
+      int row1 = (k * 7) % rows, col1 = (k * 11) % cols;
+      int row2 = (k * 13 + 3) % rows, col2 = (k * 5 + 1) % cols;
+      auto bfs = maze.getSolution(row1, col1, row2, col2, workspace);
+      auto indexed =
+          maze.getSolution(row1, col1, row2, col2, Maze::TREE_INDEX);
+
+      EXPECT_EQ(indexed, bfs);
+      EXPECT_EQ(maze.getPathLength(row1, col1, row2, col2),
+                static_cast<int>(bfs.size()) - 1);
+    }
+  }
+}
+
+TEST(tree_index, edge_cases) {
+  MazeTreeIndex empty;
+  EXPECT_FALSE(empty.isValid());
+  EXPECT_EQ(empty.pathLength(0, 0), -1);
+  EXPECT_TRUE(empty.path(0, 0).empty());
+
+  // лабиринт с петлей вокруг блока 2x2 не является деревом
+  MazeBuilder builder;
+  Maze maze = builder.createMaze(20, 20);
+  maze.grid_.removeWalls(5, 5, Maze::Wall::BOTH);
+  maze.grid_.removeWalls(5, 6, Maze::Wall::DOWN);
+  maze.grid_.removeWalls(6, 5, Maze::Wall::RIGHT);
+  EXPECT_FALSE(MazeTreeIndex(maze.grid_).isValid());
+  EXPECT_FALSE(maze.buildTreeIndex());
+
+  auto bfs = maze.getSolution(0, 0, 19, 19);
+  EXPECT_EQ(maze.getSolution(0, 0, 19, 19, Maze::TREE_INDEX), bfs);
+  EXPECT_EQ(maze.getPathLength(0, 0, 19, 19),
+            static_cast<int>(bfs.size()) - 1);
+
+  // лабиринт с изолированной ячейкой тоже не является деревом
+  Maze maze2(2, 2);
+  maze2.grid_.addWalls(0, 0, Maze::Wall::BOTH);
+  maze2.grid_.addWalls(1, 0, Maze::Wall::RIGHT);
+  EXPECT_FALSE(MazeTreeIndex(maze2.grid_).isValid());
+  EXPECT_EQ(maze2.getPathLength(0, 0, 1, 1), -1);
+  EXPECT_EQ(maze2.getPathLength(0, 0, 5, 5), -1);
+}
+
+TEST(tree_index, concurrent_queries) {
+  MazeBuilder builder;
+  const Maze maze = builder.createMaze(80, 80);
+  const Maze &shared = maze;
+
+  // индекс строится один раз при первых одновременных запросах
+  std::vector<int> lengths(8, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&shared, &lengths, t]() {
+      lengths[t] = shared.getPathLength(0, 0, 79, 79);
+      shared.getSolution(t, t, 79 - t, 79 - t, Maze::TREE_INDEX);
+    });
+  }
+  for (std::thread &thread : threads) thread.join();
+
+  int expected = static_cast<int>(maze.getSolution(0, 0, 79, 79).size()) - 1;
+  for (int length : lengths) EXPECT_EQ(length, expected);
+  EXPECT_EQ(shared.getDistanceField({{0, 0}}).distanceAt(79, 79), expected);
+
+  // копия получает собственный индекс по своим стенам
+  Maze copy = maze;
+  copy.grid_.removeWalls(0, 0, Maze::Wall::BOTH);
+  copy.grid_.removeWalls(0, 1, Maze::Wall::DOWN);
+  copy.grid_.removeWalls(1, 0, Maze::Wall::RIGHT);
+  EXPECT_FALSE(copy.buildTreeIndex());
+  EXPECT_TRUE(maze.buildTreeIndex());
+}
+
+TEST(tree_index, moved_maze) {
+  MazeBuilder builder;
+  Maze source = builder.createMaze(30, 30);
+  int expected = static_cast<int>(source.getSolution(0, 0, 29, 29).size()) - 1;
+  EXPECT_TRUE(source.buildTreeIndex());
+
+  // индекс переходит к новому объекту, исходный остается пригодным
+  Maze moved = std::move(source);
+  EXPECT_EQ(moved.getPathLength(0, 0, 29, 29), expected);
+  EXPECT_TRUE(source.isEmpty());
+  EXPECT_FALSE(source.buildTreeIndex());
+  EXPECT_EQ(source.getPathLength(0, 0, 29, 29), -1);
+  EXPECT_TRUE(source.getSolution(0, 0, 29, 29, Maze::TREE_INDEX).empty());
+
+  // перемещенный объект можно заново заполнить и опросить
+  source = moved;
+  EXPECT_TRUE(source.buildTreeIndex());
+  EXPECT_EQ(source.getPathLength(0, 0, 29, 29), expected);
+
+  Maze other = builder.createMaze(10, 10);
+  other = std::move(moved);
+  EXPECT_EQ(other.getPathLength(0, 0, 29, 29), expected);
+  EXPECT_EQ(moved.getPathLength(0, 0, 0, 0), -1);
+  moved = builder.createMaze(5, 5);
+  EXPECT_TRUE(moved.buildTreeIndex());
+  EXPECT_EQ(moved.getPathLength(0, 0, 0, 0), 0);
+}
@@ -3,7 +3,48 @@
 
 #include <gtest/gtest.h>
 
+#include <filesystem>
+#include <thread>
+
 #include "../include/maze.h"
 #include "../include/maze_builder.h"
+#include "../include/maze_codec.h"
+#include "../include/maze_compressed_writer.h"
+#include "../include/maze_serializer.h"
+
+/**
+ * @brief Проверяет, что путь состоит из соседних ячеек и ни один его шаг не
+ * пересекает стену лабиринта
+ * @param[in] grid хранилище стен лабиринта
+ * @param[in] path путь
+ * @return true, если путь корректный
+ */
+inline bool isValidPath(const MazeGrid &grid,
+                        const std::vector<std::pair<int, int>> &path) {
+  for (size_t i = 0; i + 1 < path.size(); i++) {
+    auto [row, col] = path[i];
+    auto [next_row, next_col] = path[i + 1];
+    bool blocked = true;
+    if (next_row == row && next_col == col + 1)
+      blocked = grid.hasRightWall(row, col);
+    else if (next_row == row && next_col == col - 1)
+      blocked = grid.hasRightWall(row, next_col);
+    else if (next_col == col && next_row == row + 1)
+      blocked = grid.hasDownWall(row, col);
+    else if (next_col == col && next_row == row - 1)
+      blocked = grid.hasDownWall(next_row, col);
+    if (blocked) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Возвращает путь к временному файлу для тестов
+ * @param[in] name имя файла
+ * @return Путь к файлу
+ */
+inline std::string tempFilePath(const std::string &name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
 
 #endif  // MAZE_TESTS_H
\ No newline at end of file